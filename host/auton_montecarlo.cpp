@@ -0,0 +1,153 @@
+// Runs every autonomous routine thousands of times against the simulated
+// robot, each run with its own motor strengths, wheel slip, IMU noise,
+// start-pose error and battery voltage, spread over all cores. Reports the
+// success rate, how far from the nominal end pose the robot finished, how far
+// its own pose estimate was from the truth, and the time each step took.
+// usage: auton_montecarlo [runs] [threads] [routine]
+
+#include "auton_sim.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+const uint32_t AUTON_MS = 15000;
+const uint32_t TICK_MS = 10; // AUTON_TICK_MS in main.cpp
+
+struct RunResult {
+	bool finished;
+	bool success;
+	bool missed;      // a shot left before the flywheel was up to speed, or nothing to shoot
+	bool roller_failed;
+	bool contact;     // bumped into or pushed against something on the way
+	uint32_t duration;
+	Pose pose;
+	double belief_error; // inches between the robot's estimate and the truth at the end
+	std::vector<CommandTiming> timings;
+};
+
+RunResult runOnce(const Routine& routine, const SimVariation& variation, unsigned seed) {
+	SimRobot robot(variation, seed);
+	ActionTable table = simActions(robot);
+	RoutineRunner runner(compileRoutine(routine.root, table));
+
+	RunResult result = {};
+	while (robot.getTime() < AUTON_MS) {
+		if (robot.getTime() % TICK_MS == 0 && runner.tick(robot.getTime())) {
+			result.finished = true;
+			break;
+		}
+		robot.step();
+	}
+	if (!result.finished) {
+		runner.cancel(robot.getTime());
+	}
+	result.duration = robot.getTime();
+	result.pose = robot.getPose();
+	Pose estimate = robot.getEstimate();
+	result.belief_error = std::hypot(estimate.x - result.pose.x, estimate.y - result.pose.y);
+	result.missed = robot.hits < robot.shots || robot.dry_fires > 0;
+	result.roller_failed = robot.roller_used && !robot.roller_done;
+	result.contact = robot.contacts > 0;
+	result.success = result.finished && !result.missed && !result.roller_failed;
+	result.timings = runner.getTimings();
+	return result;
+}
+
+double percentile(std::vector<double> values, double p) {
+	if (values.empty()) {
+		return 0;
+	}
+	std::sort(values.begin(), values.end());
+	size_t index = std::min(values.size() - 1, (size_t)(p * values.size()));
+	return values[index];
+}
+
+void report(const Routine& routine, const RunResult& nominal, const std::vector<RunResult>& runs) {
+	int successes = 0, missed = 0, roller_failed = 0, out_of_time = 0, contact = 0;
+	std::vector<double> durations, position_errors, heading_errors, belief_errors;
+	for (const RunResult& run : runs) {
+		successes += run.success;
+		missed += run.missed;
+		roller_failed += run.roller_failed;
+		out_of_time += !run.finished;
+		contact += run.contact;
+		durations.push_back(run.duration / 1000.0);
+		position_errors.push_back(std::hypot(run.pose.x - nominal.pose.x, run.pose.y - nominal.pose.y));
+		heading_errors.push_back(std::fabs(run.pose.heading - nominal.pose.heading));
+		belief_errors.push_back(run.belief_error);
+	}
+
+	printf("%s: %d runs, %.1f%% success, nominal %.2f s\n", routine.name, (int)runs.size(),
+	       100.0 * successes / runs.size(), nominal.duration / 1000.0);
+	printf("  failures       missed shot %d, roller %d, out of time %d\n", missed, roller_failed, out_of_time);
+	printf("  contact        %d runs touched something\n", contact);
+	printf("  time           p50 %5.2f  p90 %5.2f  p99 %5.2f s\n", percentile(durations, 0.5),
+	       percentile(durations, 0.9), percentile(durations, 0.99));
+	printf("  end position   p50 %5.2f  p90 %5.2f  p99 %5.2f in off nominal\n", percentile(position_errors, 0.5),
+	       percentile(position_errors, 0.9), percentile(position_errors, 0.99));
+	printf("  end heading    p50 %5.2f  p90 %5.2f  p99 %5.2f deg off nominal\n", percentile(heading_errors, 0.5),
+	       percentile(heading_errors, 0.9), percentile(heading_errors, 0.99));
+	printf("  end belief     p50 %5.2f  p90 %5.2f  p99 %5.2f in off the truth\n", percentile(belief_errors, 0.5),
+	       percentile(belief_errors, 0.9), percentile(belief_errors, 0.99));
+
+	// every run compiles the same tree, so the timings line up by index
+	printf("  %-32s %7s %7s %7s %6s\n", "step (ms)", "p50", "p90", "p99", "ran");
+	for (size_t i = 0; i < nominal.timings.size(); i++) {
+		std::vector<double> times;
+		for (const RunResult& run : runs) {
+			const CommandTiming& timing = run.timings[i];
+			if (timing.ran) {
+				times.push_back(timing.end - timing.start);
+			}
+		}
+		std::string name = std::string(2 * nominal.timings[i].depth, ' ') + nominal.timings[i].name;
+		printf("  %-32s %7.0f %7.0f %7.0f %5.0f%%\n", name.c_str(), percentile(times, 0.5), percentile(times, 0.9),
+		       percentile(times, 0.99), 100.0 * times.size() / runs.size());
+	}
+	printf("\n");
+}
+
+int main(int argc, char** argv) {
+	int runs = argc > 1 ? atoi(argv[1]) : 2000;
+	int threads = argc > 2 ? atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+	int only = argc > 3 ? atoi(argv[3]) : -1;
+	if (threads < 1) {
+		threads = 1;
+	}
+
+	for (size_t r = 0; r < AUTON_ROUTINES.size(); r++) {
+		if (only >= 0 && (int)r != only) {
+			continue;
+		}
+		const Routine& routine = AUTON_ROUTINES[r];
+
+		// routines that need something the simulation does not have are skipped
+		SimRobot probe(nominalVariation(), 0);
+		std::vector<std::string> errors;
+		compileRoutine(routine.root, simActions(probe), &errors);
+		if (!errors.empty()) {
+			printf("%s: skipped, %s\n\n", routine.name, errors[0].c_str());
+			continue;
+		}
+
+		RunResult nominal = runOnce(routine, nominalVariation(), 0);
+		std::vector<RunResult> results(runs);
+		std::vector<std::thread> workers;
+		for (int t = 0; t < threads; t++) {
+			workers.emplace_back([&, t] {
+				// seeded by run number so the results do not depend on the thread count
+				for (int i = t; i < runs; i += threads) {
+					std::mt19937 rng(1000 + i);
+					results[i] = runOnce(routine, randomVariation(rng), 1000 + i);
+				}
+			});
+		}
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+		report(routine, nominal, results);
+	}
+	return 0;
+}
@@ -0,0 +1,297 @@
+#include "auton_sim.h"
+#include <algorithm>
+#include <cmath>
+
+const double SHOT_ENERGY = 0.15;    // fraction of the flywheel energy a disc takes
+const uint32_t PISTON_DWELL = 300;  // ms, the dwell a full tank gives
+
+SimVariation nominalVariation() {
+	return {{1, 1, 1, 1}, {1, 1}, 1, 0, 0, 0, {0, 0, 0}, 12600, 250};
+}
+
+SimVariation randomVariation(std::mt19937& rng) {
+	std::normal_distribution<double> strength(1, 0.06);
+	std::normal_distribution<double> position(0, 1);   // inches
+	std::normal_distribution<double> heading(0, 1.5);  // degrees
+	std::uniform_real_distribution<double> traction(0.6, 1);
+	std::uniform_real_distribution<double> drift(-0.03, 0.03);
+	std::uniform_real_distribution<double> battery(11200, 12800);
+	std::uniform_int_distribution<uint32_t> roller(150, 400);
+
+	SimVariation variation;
+	for (double& motor : variation.motor_strength) {
+		motor = std::clamp(strength(rng), 0.7, 1.1);
+	}
+	for (double& motor : variation.flywheel_strength) {
+		motor = std::clamp(strength(rng), 0.7, 1.1);
+	}
+	variation.traction = traction(rng);
+	variation.imu_noise = 0.3;
+	variation.accel_noise = 0.01;
+	variation.imu_drift = drift(rng);
+	variation.start_error = {position(rng), position(rng), heading(rng)};
+	variation.battery_mv = battery(rng);
+	variation.roller_ms = roller(rng);
+	return variation;
+}
+
+SimRobot::SimRobot(const SimVariation& variation, unsigned seed)
+	: field({SIM_START_POSE.x + variation.start_error.x, SIM_START_POSE.y + variation.start_error.y,
+	         SIM_START_POSE.heading + variation.start_error.heading}),
+	  flywheel(DEFAULT_FLYWHEEL_GAINS), variation(variation), rng(seed) {
+	for (int i = 0; i < 4; i++) {
+		field.setStrength(i, variation.motor_strength[i]);
+	}
+	field.setBattery(variation.battery_mv);
+	field.setTraction(variation.traction);
+	flywheel_plant.setStrength(variation.flywheel_strength[0], variation.flywheel_strength[1]);
+	flywheel_plant.setBattery(variation.battery_mv);
+	battery.update(variation.battery_mv);
+	// the IMU is zeroed wherever the robot was actually set down
+	imu_bias = -variation.start_error.heading;
+	// and it believes it was set down exactly on the start pose
+	localization.reset(SIM_START_POSE);
+}
+
+void SimRobot::step() {
+	const double dt = 0.001;
+
+	// flywheel loop at the robot's 10 ms
+	if (time % 10 == 0) {
+		flywheel.setFeedforwardScale(battery.getScale());
+		flywheel.update(flywheel_plant.getRpm1(), flywheel_plant.getRpm2(), 0.01);
+		flywheel_plant.setVoltage(flywheel.getVoltage1(), flywheel.getVoltage2());
+	}
+	flywheel_plant.step();
+
+	// slip and contact at the robot's 10 ms odometry tick
+	if (time % 10 == 0) {
+		double wheels[4], d[4], current[4], rpm[4];
+		for (int i = 0; i < 4; i++) {
+			wheels[i] = field.getWheelPosition(i);
+			d[i] = wheels[i] - last_wheels[i];
+			last_wheels[i] = wheels[i];
+			current[i] = field.getWheelCurrent(i);
+			rpm[i] = field.getWheelVelocity(i);
+		}
+		std::normal_distribution<double> noise(0, variation.accel_noise);
+		double accel_forward = field.getAccelForward() + noise(rng);
+		double accel_right = field.getAccelRight() + noise(rng);
+		double forward = (d[0] - d[1] + d[2] - d[3]) / 4 / SIM_TICKS_PER_INCH;
+		double right = (d[0] + d[1] - d[2] - d[3]) / 4 / SIM_TICKS_PER_INCH;
+		traction.update(forward, right, accel_forward, accel_right, 0.01);
+		localization.predict(traction.getForward(), traction.getRight(), readHeading(), traction.getTraction());
+		bool was_in_contact = collision.inContact();
+		collision.update(accel_forward, accel_right, current, rpm, traction.getTraction(), time);
+		if (collision.inContact() && !was_in_contact) {
+			contacts++;
+		}
+	}
+
+	field.step();
+
+	imu_bias += variation.imu_drift * dt;
+	roller_spun += roller_speed;
+	time++;
+}
+
+uint32_t SimRobot::getTime() const {
+	return time;
+}
+
+double SimRobot::readHeading() {
+	std::normal_distribution<double> noise(0, variation.imu_noise);
+	return field.getPose().heading + imu_bias + noise(rng);
+}
+
+Pose SimRobot::getPose() const {
+	return field.getPose();
+}
+
+Pose SimRobot::getEstimate() const {
+	return localization.getPose();
+}
+
+void SimRobot::resetEstimate(const Pose& pose) {
+	imu_bias -= readHeading() - pose.heading;
+	localization.reset(pose);
+}
+
+bool SimRobot::driveSettled() const {
+	return !drive_busy;
+}
+
+void SimRobot::setDrive(double v, double h, double r) {
+	double wheels[4] = {v + h + r, -v + h + r, v - h + r, -v - h + r};
+	double scale = battery.getScale();
+	double max = 0;
+	for (double& wheel : wheels) {
+		wheel *= scale;
+		max = std::max(max, std::fabs(wheel));
+	}
+	for (int i = 0; i < 4; i++) {
+		double wheel = max > 127 ? wheels[i] * 127 / max : wheels[i];
+		field.setVoltage(i, wheel * 12000 / 127);
+	}
+}
+
+bool SimRobot::inContact() const {
+	return collision.inContact();
+}
+
+bool SimRobot::flywheelReady() const {
+	double target = flywheel.getTarget();
+	return target > 0 && std::fabs(flywheel_plant.getRpm1() - target) < target * 0.05
+		&& std::fabs(flywheel_plant.getRpm2() - target) < target * 0.05;
+}
+
+double SimRobot::rollerHue() const {
+	// red alliance: blue (220) until turned over, then red (10)
+	return roller_spun >= variation.roller_ms ? 10 : 220;
+}
+
+static CommandPtr driveCommand(SimRobot& robot, const std::string& name, double forward, double right) {
+	std::shared_ptr<DriveController> move(new DriveController(SIM_TICKS_PER_INCH));
+	FieldSim& field = robot.field;
+	return CommandPtr(new FunctionCommand(name,
+		[=, &robot, &field] {
+			robot.drive_busy = true;
+			move->start(forward, right, field.getWheelPosition(0), field.getWheelPosition(1), field.getWheelPosition(2),
+			            field.getWheelPosition(3), robot.readHeading(), robot.getTime());
+		},
+		[=, &robot, &field] {
+			move->update(field.getWheelPosition(0), field.getWheelPosition(1), field.getWheelPosition(2),
+			             field.getWheelPosition(3), robot.readHeading(), robot.getTime());
+			robot.setDrive(move->getForward(), move->getRight(), move->getRotation());
+		},
+		[=](uint32_t) { return move->isFinished(); },
+		[&robot](bool) {
+			robot.setDrive(0, 0, 0);
+			robot.drive_busy = false;
+		}));
+}
+
+static CommandPtr turnCommand(SimRobot& robot, const std::string& name, double angle) {
+	std::shared_ptr<TurnController> turn(new TurnController());
+	return CommandPtr(new FunctionCommand(name,
+		[=, &robot] {
+			robot.drive_busy = true;
+			turn->start(angle, robot.readHeading(), robot.getTime());
+		},
+		[=, &robot] { robot.setDrive(0, 0, turn->update(robot.readHeading(), robot.getTime())); },
+		[=](uint32_t) { return turn->isFinished(); },
+		[&robot](bool) {
+			robot.setDrive(0, 0, 0);
+			robot.drive_busy = false;
+		}));
+}
+
+static CommandPtr squareCommand(SimRobot& robot, const std::string& name, RobotFace face, double timeout_ms) {
+	std::shared_ptr<WallSquare> square(new WallSquare(SIM_HALF_LENGTH));
+	FieldSim& field = robot.field;
+	return CommandPtr(new FunctionCommand(name,
+		[=, &robot] {
+			robot.drive_busy = true;
+			square->start(face, robot.getEstimate(), robot.getTime(), timeout_ms);
+		},
+		[=, &robot, &field] {
+			double current[4];
+			for (int i = 0; i < 4; i++) {
+				current[i] = field.getWheelCurrent(i);
+			}
+			square->update(current, robot.readHeading(), robot.inContact(), robot.getTime());
+			robot.setDrive(square->getForward(), square->getRight(), 0);
+		},
+		[=](uint32_t) { return square->isFlush() || square->isTimedOut(); },
+		[=, &robot](bool) {
+			robot.setDrive(0, 0, 0);
+			robot.drive_busy = false;
+			if (square->isFlush()) {
+				robot.resetEstimate(square->correct(robot.getEstimate()));
+				robot.squared++;
+			}
+		}));
+}
+
+ActionTable simActions(SimRobot& robot) {
+	ActionTable table;
+	table.actions["forward"] = [&robot](double dist) {
+		return driveCommand(robot, "forward", dist, 0);
+	};
+	table.actions["reverse"] = [&robot](double dist) {
+		return driveCommand(robot, "reverse", -dist, 0);
+	};
+	table.actions["left"] = [&robot](double dist) {
+		return driveCommand(robot, "left", 0, -dist);
+	};
+	table.actions["right"] = [&robot](double dist) {
+		return driveCommand(robot, "right", 0, dist);
+	};
+	table.actions["rotate_cw"] = [&robot](double angle) {
+		return turnCommand(robot, "rotate cw", angle);
+	};
+	table.actions["rotate_ccw"] = [&robot](double angle) {
+		return turnCommand(robot, "rotate ccw", -angle);
+	};
+	table.actions["square_front"] = [&robot](double timeout_ms) {
+		return squareCommand(robot, "square front", FACE_FRONT, timeout_ms);
+	};
+	table.actions["square_back"] = [&robot](double timeout_ms) {
+		return squareCommand(robot, "square back", FACE_BACK, timeout_ms);
+	};
+	table.actions["square_left"] = [&robot](double timeout_ms) {
+		return squareCommand(robot, "square left", FACE_LEFT, timeout_ms);
+	};
+	table.actions["square_right"] = [&robot](double timeout_ms) {
+		return squareCommand(robot, "square right", FACE_RIGHT, timeout_ms);
+	};
+	table.actions["flywheel"] = [&robot](double rpm) {
+		return CommandPtr(new FunctionCommand("flywheel " + std::to_string((int)rpm),
+			[=, &robot] { robot.flywheel.setTarget(rpm); }));
+	};
+	table.actions["fire"] = [&robot](double) {
+		std::vector<CommandPtr> steps;
+		steps.emplace_back(new FunctionCommand("piston out", [&robot] {
+			if (robot.discs == 0) {
+				robot.dry_fires++;
+				return;
+			}
+			robot.discs--;
+			robot.shots++;
+			if (robot.flywheelReady()) {
+				robot.hits++;
+			}
+			robot.flywheel_plant.shoot(SHOT_ENERGY);
+		}));
+		steps.emplace_back(new WaitCommand(PISTON_DWELL));
+		steps.emplace_back(new FunctionCommand("piston in", nullptr));
+		steps.emplace_back(new WaitCommand(100));
+		return CommandPtr(new SequentialGroup(std::move(steps), "fire"));
+	};
+	table.actions["roller"] = [&robot](double) {
+		std::shared_ptr<RollerController> roller(new RollerController());
+		return CommandPtr(new FunctionCommand("roller",
+			[=, &robot] {
+				robot.roller_used = true;
+				roller->start(ROLLER_RED, robot.getTime());
+			},
+			nullptr,
+			[=, &robot](uint32_t) {
+				bool finished = roller->update(robot.rollerHue(), 0.8, 200, robot.getTime());
+				robot.roller_speed = roller->getSpeed();
+				return finished;
+			},
+			[=, &robot](bool) {
+				robot.roller_speed = 0;
+				robot.roller_done = roller->getState() == ROLLER_DONE;
+			}));
+	};
+	table.actions["intake"] = [](double vel) {
+		return CommandPtr(new FunctionCommand("intake " + std::to_string((int)vel), nullptr));
+	};
+	table.conditions["flywheel_ready"] = [&robot] { return robot.flywheelReady(); };
+	table.conditions["drive_settled"] = [&robot] { return robot.driveSettled(); };
+	table.conditions["disc_ready"] = [&robot] { return robot.discs > 0; };
+	table.conditions["contact"] = [&robot] { return robot.inContact(); };
+	return table;
+}
@@ -0,0 +1,112 @@
+// Simulated robot for running autonomous routines on a computer.
+// Drives and turns run the robot's DriveController and TurnController on the
+// simulated encoders and IMU. The robot keeps its own belief of the pose by
+// turning the encoder deltas into a displacement and passing it through the
+// same TractionMonitor and Localization as main.cpp. The chassis is the
+// rigid-body FieldSim with wheel slip and the perimeter walls, and the
+// flywheel is the two-motor plant under the robot's DualFlywheel controller.
+// simActions() gives the same action and condition names as robotActions() in
+// main.cpp, so the routines in Routines.cpp run unchanged.
+
+#ifndef AUTON_SIM_H
+#define AUTON_SIM_H
+
+#include "Routine.h"
+#include "Odometry.h" // Pose
+#include "DualFlywheel.h"
+#include "BatteryCompensation.h"
+#include "field_sim.h"
+#include "RollerController.h"
+#include "TurnController.h"
+#include "DriveController.h"
+#include "TractionMonitor.h"
+#include "CollisionDetector.h"
+#include "Localization.h"
+#include "WallSquare.h"
+#include <random>
+
+// same scales as main.cpp
+const double SIM_TICKS_PER_INCH = 1000.0 / 13;
+const double SIM_TICKS_PER_DEGREE = 1000.0 / 81;
+const Pose SIM_START_POSE = {-35, -58, 0};
+const double SIM_HALF_LENGTH = 7.5; // ROBOT_HALF_LENGTH
+
+// what changes from one run to the next
+struct SimVariation {
+	double motor_strength[4]; // fl, fr, bl, br; 1 is a healthy motor
+	double flywheel_strength[2];
+	double traction;          // floor grip, 1 for a clean field
+	double imu_noise;         // degrees, per reading
+	double accel_noise;       // g, per accelerometer reading
+	double imu_drift;         // degrees per second
+	Pose start_error;
+	double battery_mv;
+	uint32_t roller_ms;       // spinning needed to turn the roller over
+};
+
+// no randomness: the routine as written
+SimVariation nominalVariation();
+SimVariation randomVariation(std::mt19937& rng);
+
+class SimRobot {
+public:
+	SimRobot(const SimVariation& variation, unsigned seed);
+
+	// one 1 ms physics step
+	void step();
+	uint32_t getTime() const;
+
+	// what the robot believes: IMU heading with noise and drift
+	double readHeading();
+	// where it really is, in the field frame
+	Pose getPose() const;
+	// where it thinks it is
+	Pose getEstimate() const;
+	// what squareCommand() does once flush: new belief, IMU offset to match
+	void resetEstimate(const Pose& pose);
+
+	bool driveSettled() const;
+	// the x-drive mixer from main.cpp, stick units
+	void setDrive(double v, double h, double r);
+	// set while a drive or turn command has the drive
+	bool drive_busy = false;
+	bool flywheelReady() const;
+	bool inContact() const;
+
+	// counters for judging a run
+	int shots = 0;
+	int hits = 0;         // flywheel within 5 % when the disc left
+	int dry_fires = 0;
+	int discs = 2;        // preload
+	bool roller_used = false;
+	bool roller_done = false;
+
+	FieldSim field;
+	DualFlywheelSimulator flywheel_plant;
+	DualFlywheel flywheel;
+	BatteryCompensation battery;
+	// run on the robot's 10 ms odometry tick
+	TractionMonitor traction;
+	CollisionDetector collision;
+	Localization localization;
+	int contacts = 0;
+	int squared = 0;      // wall squares that ended flush
+
+	// roller under the intake: ms of full-speed spinning so far
+	double roller_spun = 0;
+	double roller_speed = 0;
+	// hue the optical sensor sees, the opponent's color until the roller turns over
+	double rollerHue() const;
+
+private:
+	SimVariation variation;
+	std::mt19937 rng;
+	double imu_bias = 0;
+	double last_wheels[4] = {0, 0, 0, 0};
+	uint32_t time = 0;
+};
+
+// action table driving a SimRobot
+ActionTable simActions(SimRobot& robot);
+
+#endif
@@ -0,0 +1,188 @@
+#include "field_sim.h"
+#include <algorithm>
+#include <cmath>
+
+const double INCH = 0.0254;
+const double GRAVITY = 9.81;
+const double DT = 0.001;
+
+// same scales as main.cpp
+const double TICKS_PER_INCH = 1000.0 / 13;
+const double TICKS_PER_DEGREE = 1000.0 / 81;
+
+// V5 motor with the 200 rpm cartridge
+const double STALL_TORQUE = 2.1;               // N m
+const double FREE_SPEED = 200 * 2 * M_PI / 60; // rad/s
+const double STALL_CURRENT = 2500;             // mA, the firmware limit
+const double MAX_MV = 12000;
+const double REFERENCE_BATTERY = 12600;
+
+// rolling direction of each wheel in the robot frame (x right, y forward)
+// and which corner it sits on
+const double S = M_SQRT1_2;
+const double WHEEL_DIRECTION[4][2] = {{S, S}, {S, -S}, {-S, S}, {-S, -S}};
+const double WHEEL_CORNER[4][2] = {{-1, 1}, {1, 1}, {-1, -1}, {1, -1}};
+
+FieldSim::FieldSim(const Pose& start, const ChassisParams& params)
+	: params(params), x(start.x * INCH), y(start.y * INCH), heading(start.heading * M_PI / 180) {
+	double width = 2 * params.half_size;
+	inertia = params.mass * width * width / 6;
+	// driving an inch forward moves each wheel's floor contact 1/sqrt(2) inch
+	// along its rolling direction
+	double meters_per_degree = S * INCH / TICKS_PER_INCH;
+	wheel_radius = meters_per_degree * 180 / M_PI;
+	// turning a degree moves each wheel sqrt(2) * offset * 1 degree
+	wheel_offset = TICKS_PER_DEGREE * meters_per_degree * 180 / M_PI / M_SQRT2;
+}
+
+void FieldSim::setVoltage(int wheel, double mv) {
+	voltage[wheel] = std::clamp(mv, -MAX_MV, MAX_MV);
+}
+
+void FieldSim::setBattery(double battery_mv) {
+	battery = battery_mv;
+}
+
+void FieldSim::setStrength(int wheel, double new_strength) {
+	strength[wheel] = new_strength;
+}
+
+void FieldSim::setTraction(double new_traction) {
+	traction = new_traction;
+}
+
+void FieldSim::step() {
+	double sin_h = std::sin(heading), cos_h = std::cos(heading);
+	// field velocity in the robot frame
+	double bx = vx * cos_h - vy * sin_h;
+	double by = vx * sin_h + vy * cos_h;
+
+	double normal = params.mass * GRAVITY / 4;
+	double grip = params.wheel_mu * traction * normal;
+	double fx = 0, fy = 0, torque = 0; // robot frame, torque clockwise
+
+	for (int i = 0; i < 4; i++) {
+		double px = WHEEL_CORNER[i][0] * wheel_offset;
+		double py = WHEEL_CORNER[i][1] * wheel_offset;
+		double ux = WHEEL_DIRECTION[i][0], uy = WHEEL_DIRECTION[i][1];
+		// contact point velocity, a clockwise yaw rate moves (px, py) along (py, -px)
+		double cx = bx + yaw_rate * py;
+		double cy = by - yaw_rate * px;
+		double along = cx * ux + cy * uy;
+		double across = cx * uy - cy * ux;
+
+		double slip = wheel_speed[i] * wheel_radius - along;
+		double drive = grip * std::tanh(slip / params.slip_speed);
+		double drag = std::clamp(-params.roller_drag * across, -grip, grip);
+		double force_x = drive * ux + drag * uy;
+		double force_y = drive * uy - drag * ux;
+		fx += force_x;
+		fy += force_y;
+		torque += force_x * py - force_y * px;
+
+		double applied = voltage[i] / MAX_MV * battery / REFERENCE_BATTERY;
+		double load = std::clamp(applied - wheel_speed[i] / FREE_SPEED, -1.0, 1.0);
+		double motor = strength[i] * STALL_TORQUE * load;
+		current[i] = STALL_CURRENT * load;
+		double friction = params.motor_friction * std::tanh(wheel_speed[i] / 0.5);
+		wheel_speed[i] += (motor - friction - drive * wheel_radius) / params.wheel_inertia * DT;
+		wheel_angle[i] += wheel_speed[i] * DT;
+	}
+
+	// back to the field frame
+	double ax = (fx * cos_h + fy * sin_h) / params.mass;
+	double ay = (-fx * sin_h + fy * cos_h) / params.mass;
+	double alpha = torque / inertia;
+
+	// perimeter: each chassis corner is pushed back out of the walls
+	wall_force = 0;
+	double limit = FIELD_HALF_SIZE * INCH;
+	for (int c = 0; c < 4; c++) {
+		double rx_body = WHEEL_CORNER[c][0] * params.half_size;
+		double ry_body = WHEEL_CORNER[c][1] * params.half_size;
+		double rx = rx_body * cos_h + ry_body * sin_h;
+		double ry = -rx_body * sin_h + ry_body * cos_h;
+		double corner_vx = vx + yaw_rate * ry;
+		double corner_vy = vy - yaw_rate * rx;
+		for (int axis = 0; axis < 2; axis++) {
+			double position = (axis == 0 ? x + rx : y + ry);
+			double depth = std::fabs(position) - limit;
+			if (depth <= 0) {
+				continue;
+			}
+			double outward = position > 0 ? 1 : -1;
+			double normal_speed = (axis == 0 ? corner_vx : corner_vy) * outward;
+			double push = std::max(0.0, params.wall_stiffness * depth + params.wall_damping * normal_speed);
+			double slide = axis == 0 ? corner_vy : corner_vx;
+			double rub = -params.wall_mu * push * std::tanh(slide / 0.02);
+			double wall_x = axis == 0 ? -outward * push : rub;
+			double wall_y = axis == 0 ? rub : -outward * push;
+			ax += wall_x / params.mass;
+			ay += wall_y / params.mass;
+			alpha += (wall_x * ry - wall_y * rx) / inertia;
+			wall_force += push;
+		}
+	}
+
+	accel_x = ax;
+	accel_y = ay;
+	vx += ax * DT;
+	vy += ay * DT;
+	yaw_rate += alpha * DT;
+	x += vx * DT;
+	y += vy * DT;
+	heading += yaw_rate * DT;
+	time++;
+}
+
+uint32_t FieldSim::getTime() const {
+	return time;
+}
+
+Pose FieldSim::getPose() const {
+	return {x / INCH, y / INCH, heading * 180 / M_PI};
+}
+
+double FieldSim::getYawRate() const {
+	return yaw_rate * 180 / M_PI;
+}
+
+double FieldSim::getWheelPosition(int wheel) const {
+	return wheel_angle[wheel] * 180 / M_PI;
+}
+
+double FieldSim::getWheelVelocity(int wheel) const {
+	return wheel_speed[wheel] * 60 / (2 * M_PI);
+}
+
+double FieldSim::getWheelCurrent(int wheel) const {
+	return current[wheel];
+}
+
+double FieldSim::getAccelForward() const {
+	return (accel_x * std::sin(heading) + accel_y * std::cos(heading)) / GRAVITY;
+}
+
+double FieldSim::getAccelRight() const {
+	return (accel_x * std::cos(heading) - accel_y * std::sin(heading)) / GRAVITY;
+}
+
+double FieldSim::getWallForce() const {
+	return wall_force;
+}
+
+int FieldSim::getRollerContact() const {
+	double sin_h = std::sin(heading), cos_h = std::cos(heading);
+	for (int i = 0; i < NUM_ROLLERS; i++) {
+		// roller in the robot frame, then its distance outside the chassis square
+		double dx = ROLLERS[i].x * INCH - x, dy = ROLLERS[i].y * INCH - y;
+		double bx = dx * cos_h - dy * sin_h;
+		double by = dx * sin_h + dy * cos_h;
+		double gap_x = std::max(0.0, std::fabs(bx) - params.half_size);
+		double gap_y = std::max(0.0, std::fabs(by) - params.half_size);
+		if (std::hypot(gap_x, gap_y) < 0.03) {
+			return i;
+		}
+	}
+	return -1;
+}
@@ -0,0 +1,83 @@
+// Rigid-body simulation of the x-drive on the field.
+// The chassis is a square with mass and inertia. Each of the four omni wheels
+// is driven by a V5 motor model through its own inertia and grips the floor
+// along its rolling direction with saturating (slipping) friction; the free
+// rollers across it only add a little drag. The chassis corners collide with
+// the perimeter walls. The wheel geometry is derived from the encoder scales
+// in main.cpp, so encoder readings match what the robot code expects.
+// Steps at a fixed 1 ms and uses no randomness, so a run is repeatable to the
+// bit on the same machine.
+
+#ifndef FIELD_SIM_H
+#define FIELD_SIM_H
+
+#include "Odometry.h"
+#include "Field.h"
+#include <cstdint>
+
+struct ChassisParams {
+	double mass = 6.8;          // kg
+	double half_size = 0.19;    // m, half the bumper-to-bumper width
+	double wheel_mu = 0.9;      // floor grip along the wheel
+	double slip_speed = 0.05;   // m/s of slip at which the grip saturates
+	double roller_drag = 2;     // N per m/s across the wheel (free rollers)
+	double wheel_inertia = 0.003; // kg m^2 at the motor output, wheel and gears
+	double motor_friction = 0.03; // N m
+	double wall_stiffness = 20000; // N/m
+	double wall_damping = 200;     // N per m/s
+	double wall_mu = 0.3;
+};
+
+class FieldSim {
+public:
+	// wheels are front left, front right, back left, back right everywhere
+	FieldSim(const Pose& start, const ChassisParams& params = ChassisParams());
+
+	// motor voltage in mV, positive the way move() turns the motor
+	void setVoltage(int wheel, double mv);
+	void setBattery(double battery_mv);
+	// 1 is a healthy motor
+	void setStrength(int wheel, double strength);
+	// scales the floor grip, below 1 for a dusty field
+	void setTraction(double traction);
+
+	void step();
+	uint32_t getTime() const; // ms
+
+	// inches and degrees in the field frame, as Odometry reports them
+	Pose getPose() const;
+	double getYawRate() const;                // degrees per second, clockwise
+	double getWheelPosition(int wheel) const; // motor encoder degrees
+	double getWheelVelocity(int wheel) const; // motor rpm
+	double getWheelCurrent(int wheel) const;  // mA, 2500 at stall
+	// chassis acceleration in the robot frame, g, as the IMU accelerometer reads it
+	double getAccelForward() const;
+	double getAccelRight() const;
+
+	// total force the walls are pushing with, N
+	double getWallForce() const;
+	// roller the chassis is touching, -1 for none
+	int getRollerContact() const;
+
+private:
+	ChassisParams params;
+	double inertia;
+	double wheel_offset;   // m, wheel x and y from the center
+	double wheel_radius;   // m of floor travel per radian of motor
+
+	double x, y, heading;  // m, m, rad
+	double vx = 0, vy = 0; // m/s, field frame
+	double yaw_rate = 0;   // rad/s, clockwise
+	double accel_x = 0, accel_y = 0; // m/s^2, field frame, last step
+	double wheel_angle[4] = {0, 0, 0, 0}; // rad at the motor
+	double wheel_speed[4] = {0, 0, 0, 0}; // rad/s
+	double voltage[4] = {0, 0, 0, 0};
+	double current[4] = {0, 0, 0, 0};
+	double strength[4] = {1, 1, 1, 1};
+	double battery = 12600;
+	double traction = 1;
+	double wall_force = 0;
+	uint32_t time = 0;
+};
+
+#endif
@@ -0,0 +1,126 @@
+// Runs one autonomous routine on the simulated robot with nothing varied and
+// writes where the chassis was every 10 ms, for plotting or as a regression
+// reference. The simulation is deterministic, so a routine or controller
+// change that moves the robot shows up as a difference against a saved trace.
+// usage: field_trace [routine] [out.csv]
+//        field_trace [routine] --check ref.csv
+
+#include "auton_sim.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+const uint32_t AUTON_MS = 15000;
+const uint32_t TICK_MS = 10;        // AUTON_TICK_MS in main.cpp
+const double CHECK_INCHES = 0.01;   // allowed drift from the reference
+const double CHECK_DEGREES = 0.01;
+
+struct TracePoint {
+	uint32_t time;
+	Pose pose;
+	double wall_force;
+	int roller;
+};
+
+std::vector<TracePoint> runTrace(const Routine& routine) {
+	SimRobot robot(nominalVariation(), 0);
+	ActionTable table = simActions(robot);
+	RoutineRunner runner(compileRoutine(routine.root, table));
+
+	std::vector<TracePoint> trace;
+	bool done = false;
+	while (robot.getTime() < AUTON_MS) {
+		if (robot.getTime() % TICK_MS == 0) {
+			trace.push_back({robot.getTime(), robot.getPose(), robot.field.getWallForce(),
+			                 robot.field.getRollerContact()});
+			if (done) {
+				break;
+			}
+			done = runner.tick(robot.getTime());
+		}
+		robot.step();
+	}
+	return trace;
+}
+
+bool loadTrace(const char* path, std::vector<TracePoint>& trace) {
+	FILE* file = fopen(path, "r");
+	if (file == nullptr) {
+		return false;
+	}
+	char line[256];
+	fgets(line, sizeof(line), file); // header
+	TracePoint point;
+	unsigned time;
+	while (fscanf(file, "%u,%lf,%lf,%lf,%lf,%d", &time, &point.pose.x, &point.pose.y, &point.pose.heading,
+	              &point.wall_force, &point.roller) == 6) {
+		point.time = time;
+		trace.push_back(point);
+	}
+	fclose(file);
+	return true;
+}
+
+void writeTrace(FILE* file, const std::vector<TracePoint>& trace) {
+	fprintf(file, "time_ms,x,y,heading,wall_n,roller\n");
+	for (const TracePoint& point : trace) {
+		fprintf(file, "%u,%.4f,%.4f,%.4f,%.1f,%d\n", point.time, point.pose.x, point.pose.y, point.pose.heading,
+		        point.wall_force, point.roller);
+	}
+}
+
+int main(int argc, char** argv) {
+	int index = argc > 1 ? atoi(argv[1]) : 0;
+	const char* out = nullptr;
+	const char* check = nullptr;
+	if (argc > 3 && strcmp(argv[2], "--check") == 0) {
+		check = argv[3];
+	} else if (argc > 2) {
+		out = argv[2];
+	}
+	if (index < 0 || index >= (int)AUTON_ROUTINES.size()) {
+		fprintf(stderr, "routine %d out of range, %d routines\n", index, (int)AUTON_ROUTINES.size());
+		return 1;
+	}
+	const Routine& routine = AUTON_ROUTINES[index];
+	std::vector<TracePoint> trace = runTrace(routine);
+	const Pose& end = trace.back().pose;
+	fprintf(stderr, "%s: %.2f s, ends at (%.2f, %.2f) heading %.2f\n", routine.name, trace.back().time / 1000.0,
+	        end.x, end.y, end.heading);
+
+	if (check != nullptr) {
+		std::vector<TracePoint> reference;
+		if (!loadTrace(check, reference)) {
+			fprintf(stderr, "could not read %s\n", check);
+			return 1;
+		}
+		if (reference.size() != trace.size()) {
+			printf("FAIL: %d points, reference has %d\n", (int)trace.size(), (int)reference.size());
+			return 1;
+		}
+		for (size_t i = 0; i < trace.size(); i++) {
+			const Pose& a = trace[i].pose;
+			const Pose& b = reference[i].pose;
+			if (std::hypot(a.x - b.x, a.y - b.y) > CHECK_INCHES || std::fabs(a.heading - b.heading) > CHECK_DEGREES) {
+				printf("FAIL: at %u ms (%.2f, %.2f, %.2f), reference (%.2f, %.2f, %.2f)\n", trace[i].time, a.x, a.y,
+				       a.heading, b.x, b.y, b.heading);
+				return 1;
+			}
+		}
+		printf("OK: %d points match %s\n", (int)trace.size(), check);
+		return 0;
+	}
+
+	FILE* file = out != nullptr ? fopen(out, "w") : stdout;
+	if (file == nullptr) {
+		fprintf(stderr, "could not write %s\n", out);
+		return 1;
+	}
+	writeTrace(file, trace);
+	if (file != stdout) {
+		fclose(file);
+	}
+	return 0;
+}
@@ -0,0 +1,337 @@
+// Identifies the flywheel from a log written by the robot (LOG_FLYWHEEL in
+// RobotSpecifics.h puts it at /usd/flywheel.csv): per motor
+//   voltage = kS sign(speed) + kV speed + kA acceleration
+// by least squares over the samples away from shots, and the fraction of
+// kinetic energy each disc takes, found by replaying the logged voltages
+// around every shot through the fitted motors and matching the speed. The fit
+// is checked by replaying the logged voltages through the simulator run from
+// the fitted model. --simulate writes a log from the physical simulator
+// instead, so the fit can be checked against known values.
+// usage: flywheel_fit log.csv [--save model.txt]
+//        flywheel_fit --simulate log.csv
+
+#include "flywheel_scenario.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+struct Sample {
+	double time;  // ms
+	double rpm[2];
+	double mv[2];
+	double battery_mv;
+	bool shot;
+	double smooth[2];
+	double accel[2]; // rpm per second
+};
+
+const double REFERENCE_BATTERY = 12600; // the simulator's commands are relative to this
+const double SHOT_BEFORE = 50;   // ms of steady speed taken before a shot
+const double SHOT_AFTER = 250;   // ms after a shot matched against the replay
+const double SHOT_EXCLUDE = 300; // ms after a shot left out of the motor fit
+
+bool loadLog(const char* path, std::vector<Sample>& samples) {
+	FILE* file = fopen(path, "r");
+	if (file == nullptr) {
+		return false;
+	}
+	char line[256];
+	while (fgets(line, sizeof(line), file)) {
+		Sample sample = {};
+		int shot = 0;
+		if (sscanf(line, "%lf,%lf,%lf,%lf,%lf,%lf,%d", &sample.time, &sample.rpm[0], &sample.rpm[1], &sample.mv[0],
+		           &sample.mv[1], &sample.battery_mv, &shot) == 7) {
+			sample.shot = shot != 0;
+			samples.push_back(sample);
+		}
+	}
+	fclose(file);
+	return samples.size() > 10;
+}
+
+// centered moving average, then a central difference for the acceleration
+void differentiate(std::vector<Sample>& samples) {
+	const int half = 2;
+	int n = samples.size();
+	for (int i = 0; i < n; i++) {
+		for (int m = 0; m < 2; m++) {
+			double sum = 0;
+			int count = 0;
+			for (int j = std::max(0, i - half); j <= std::min(n - 1, i + half); j++) {
+				sum += samples[j].rpm[m];
+				count++;
+			}
+			samples[i].smooth[m] = sum / count;
+		}
+	}
+	for (int i = 0; i < n; i++) {
+		int a = std::max(0, i - half), b = std::min(n - 1, i + half);
+		double dt = (samples[b].time - samples[a].time) / 1000;
+		for (int m = 0; m < 2; m++) {
+			samples[i].accel[m] = dt > 0 ? (samples[b].smooth[m] - samples[a].smooth[m]) / dt : 0;
+		}
+	}
+}
+
+// solves the 3x3 normal equations by Cramer's rule
+bool solve3(const double a[3][3], const double b[3], double x[3]) {
+	auto det = [](const double m[3][3]) {
+		return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+			+ m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+	};
+	double d = det(a);
+	if (std::fabs(d) < 1e-12) {
+		return false;
+	}
+	for (int c = 0; c < 3; c++) {
+		double m[3][3];
+		for (int r = 0; r < 3; r++) {
+			for (int k = 0; k < 3; k++) {
+				m[r][k] = k == c ? b[r] : a[r][k];
+			}
+		}
+		x[c] = det(m) / d;
+	}
+	return true;
+}
+
+bool nearShot(const std::vector<Sample>& samples, size_t i) {
+	for (size_t j = 0; j < samples.size(); j++) {
+		if (samples[j].shot && samples[i].time >= samples[j].time - SHOT_BEFORE
+		    && samples[i].time <= samples[j].time + SHOT_EXCLUDE) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool fitMotor(const std::vector<Sample>& samples, int m, double& kS, double& kV, double& kA, int& used) {
+	double a[3][3] = {}, b[3] = {};
+	used = 0;
+	for (size_t i = 0; i < samples.size(); i++) {
+		const Sample& s = samples[i];
+		// standing still says nothing about kV or kA, and shots are not the motor
+		if (std::fabs(s.smooth[m]) < 5 || nearShot(samples, i)) {
+			continue;
+		}
+		double x[3] = {s.smooth[m] > 0 ? 1.0 : -1.0, s.smooth[m], s.accel[m]};
+		double y = s.mv[m] * s.battery_mv / REFERENCE_BATTERY;
+		for (int r = 0; r < 3; r++) {
+			for (int c = 0; c < 3; c++) {
+				a[r][c] += x[r] * x[c];
+			}
+			b[r] += x[r] * y;
+		}
+		used++;
+	}
+	double k[3];
+	if (used < 20 || !solve3(a, b, k)) {
+		return false;
+	}
+	kS = k[0];
+	kV = k[1];
+	kA = k[2];
+	return true;
+}
+
+// squared speed error over one shot window when the shot takes energy:
+// starts from the steady speed before the shot and replays the logged
+// voltages through the fitted motors, so the energy the loop puts back while
+// the speed is down is not mistaken for a smaller shot
+double shotError(const std::vector<Sample>& samples, size_t start, size_t shot, size_t end, double rpm1, double rpm2,
+                 const FlywheelModel& model, double energy) {
+	DualFlywheelSimulator plant;
+	plant.setModel(model);
+	plant.setRpm(rpm1, rpm2);
+	double error = 0;
+	for (size_t i = start; i < end; i++) {
+		const Sample& s = samples[i];
+		if (i == shot) {
+			plant.shoot(energy);
+		}
+		if (i >= shot) {
+			error += std::pow(plant.getRpm1() - s.rpm[0], 2) + std::pow(plant.getRpm2() - s.rpm[1], 2);
+		}
+		plant.setBattery(s.battery_mv);
+		plant.setVoltage(s.mv[0], s.mv[1]);
+		int steps = (int)std::lround((samples[i + 1].time - s.time) / 1000 / plant.getTimestep());
+		for (int k = 0; k < steps; k++) {
+			plant.step();
+		}
+	}
+	return error;
+}
+
+double fitShotEnergy(const std::vector<Sample>& samples, const FlywheelModel& model, int& shots) {
+	double total = 0;
+	shots = 0;
+	for (size_t i = 0; i < samples.size(); i++) {
+		if (!samples[i].shot) {
+			continue;
+		}
+		// steady speed over SHOT_BEFORE, replayed from its first sample
+		size_t start = i;
+		double before[2] = {0, 0};
+		int count = 0;
+		while (start > 0 && samples[start - 1].time >= samples[i].time - SHOT_BEFORE) {
+			start--;
+			before[0] += samples[start].rpm[0];
+			before[1] += samples[start].rpm[1];
+			count++;
+		}
+		size_t end = i;
+		while (end + 1 < samples.size() && samples[end].time <= samples[i].time + SHOT_AFTER) {
+			end++;
+		}
+		if (count == 0 || end <= i) {
+			continue;
+		}
+		// the error is one dip in the energy, golden-section search for it
+		const double ratio = (std::sqrt(5.0) - 1) / 2;
+		double lo = 0, hi = 0.9;
+		double a = hi - ratio * (hi - lo), b = lo + ratio * (hi - lo);
+		double fa = shotError(samples, start, i, end, before[0] / count, before[1] / count, model, a);
+		double fb = shotError(samples, start, i, end, before[0] / count, before[1] / count, model, b);
+		while (hi - lo > 1e-4) {
+			if (fa < fb) {
+				hi = b;
+				b = a;
+				fb = fa;
+				a = hi - ratio * (hi - lo);
+				fa = shotError(samples, start, i, end, before[0] / count, before[1] / count, model, a);
+			}
+			else {
+				lo = a;
+				a = b;
+				fa = fb;
+				b = lo + ratio * (hi - lo);
+				fb = shotError(samples, start, i, end, before[0] / count, before[1] / count, model, b);
+			}
+		}
+		total += (lo + hi) / 2;
+		shots++;
+	}
+	return shots > 0 ? total / shots : 0;
+}
+
+// replays the logged voltages open loop, returns the rms speed error per motor
+void replay(const std::vector<Sample>& samples, DualFlywheelSimulator& plant, double shot_energy, double rms[2]) {
+	double sum[2] = {0, 0};
+	for (size_t i = 0; i + 1 < samples.size(); i++) {
+		const Sample& s = samples[i];
+		if (s.shot) {
+			plant.shoot(shot_energy);
+		}
+		plant.setBattery(s.battery_mv);
+		plant.setVoltage(s.mv[0], s.mv[1]);
+		int steps = (int)std::lround((samples[i + 1].time - s.time) / 1000 / plant.getTimestep());
+		for (int k = 0; k < steps; k++) {
+			plant.step();
+		}
+		sum[0] += std::pow(plant.getRpm1() - samples[i + 1].rpm[0], 2);
+		sum[1] += std::pow(plant.getRpm2() - samples[i + 1].rpm[1], 2);
+	}
+	rms[0] = std::sqrt(sum[0] / (samples.size() - 1));
+	rms[1] = std::sqrt(sum[1] / (samples.size() - 1));
+}
+
+// a practice session on the mismatched physical plant: a few targets, a few
+// shots, noisy speed readings, in the format the robot writes
+bool simulateLog(const char* path) {
+	FILE* file = fopen(path, "w");
+	if (file == nullptr) {
+		return false;
+	}
+	fprintf(file, "time_ms,rpm1,rpm2,mv1,mv2,battery_mv,shot\n");
+	const FlywheelPlantSetup& setup = MISMATCHED_PLANT;
+	DualFlywheelSimulator plant;
+	plant.setStaticFriction(setup.static_friction[0], setup.static_friction[1]);
+	plant.setDynamicFriction(setup.dynamic_friction[0], setup.dynamic_friction[1]);
+	plant.setStrength(setup.strength[0], setup.strength[1]);
+	DualFlywheel flywheel(DEFAULT_FLYWHEEL_GAINS);
+	std::mt19937 rng(7);
+	std::normal_distribution<double> noise(0, 1.5);
+
+	const double targets[] = {110, 150, 0, 166, 130, 0};
+	double battery = 12700;
+	for (int phase = 0; phase < 6; phase++) {
+		flywheel.setTarget(targets[phase]);
+		for (int tick = 0; tick < 400; tick++) {
+			bool shot = targets[phase] > 0 && tick > 0 && tick % 100 == 0;
+			if (shot) {
+				plant.shoot(0.15);
+			}
+			battery -= 0.2;
+			plant.setBattery(battery);
+			double rpm1 = plant.getRpm1() + noise(rng), rpm2 = plant.getRpm2() + noise(rng);
+			flywheel.update(rpm1, rpm2, 0.01);
+			plant.setVoltage(flywheel.getVoltage1(), flywheel.getVoltage2());
+			fprintf(file, "%d,%.1f,%.1f,%.0f,%.0f,%.0f,%d\n", (phase * 400 + tick) * 10, rpm1, rpm2,
+			        flywheel.getVoltage1(), flywheel.getVoltage2(), battery, shot ? 1 : 0);
+			for (int k = 0; k < 10; k++) {
+				plant.step();
+			}
+		}
+	}
+	fclose(file);
+	return true;
+}
+
+int main(int argc, char** argv) {
+	if (argc > 2 && strcmp(argv[1], "--simulate") == 0) {
+		if (!simulateLog(argv[2])) {
+			fprintf(stderr, "can't write %s\n", argv[2]);
+			return 1;
+		}
+		printf("wrote %s; expect about kS 229/952 mV, kV 60/60 mV per rpm, kA 30/33, shot energy about 0.15\n", argv[2]);
+		return 0;
+	}
+	if (argc < 2) {
+		fprintf(stderr, "usage: flywheel_fit log.csv [--save model.txt]\n       flywheel_fit --simulate log.csv\n");
+		return 1;
+	}
+
+	std::vector<Sample> samples;
+	if (!loadLog(argv[1], samples)) {
+		fprintf(stderr, "can't read a log from %s\n", argv[1]);
+		return 1;
+	}
+	differentiate(samples);
+
+	FlywheelModel model;
+	for (int m = 0; m < 2; m++) {
+		int used;
+		if (!fitMotor(samples, m, model.kS[m], model.kV[m], model.kA[m], used)) {
+			fprintf(stderr, "not enough spinning samples to fit motor %d\n", m + 1);
+			return 1;
+		}
+		printf("motor %d: kS %7.1f mV  kV %6.2f mV/rpm  kA %6.2f mV/(rpm/s)  from %d samples\n", m + 1, model.kS[m],
+		       model.kV[m], model.kA[m], used);
+	}
+	int shots;
+	model.shot_energy = fitShotEnergy(samples, model, shots);
+	printf("shot energy %.3f of the kinetic energy, from %d shots\n", model.shot_energy, shots);
+
+	double fitted_rms[2], default_rms[2];
+	DualFlywheelSimulator fitted;
+	fitted.setModel(model);
+	replay(samples, fitted, model.shot_energy, fitted_rms);
+	DualFlywheelSimulator physical;
+	replay(samples, physical, 0.15, default_rms);
+	printf("replay rms error: fitted %.1f / %.1f rpm, default simulator %.1f / %.1f rpm\n", fitted_rms[0],
+	       fitted_rms[1], default_rms[0], default_rms[1]);
+
+	printf("\nfeedforward for DEFAULT_FLYWHEEL_GAINS: kV %.0f, kS1 %.0f, kS2 %.0f\n",
+	       (model.kV[0] + model.kV[1]) / 2, model.kS[0], model.kS[1]);
+
+	if (argc > 3 && strcmp(argv[2], "--save") == 0) {
+		if (!saveFlywheelModel(argv[3], model)) {
+			fprintf(stderr, "can't write %s\n", argv[3]);
+			return 1;
+		}
+		printf("saved to %s, use with flywheel_sync/flywheel_tune --model %s\n", argv[3], argv[3]);
+	}
+	return 0;
+}
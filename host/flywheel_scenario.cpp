@@ -0,0 +1,133 @@
+#include "flywheel_scenario.h"
+#include "BatteryCompensation.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+const double SHOTS[SCENARIO_SHOTS] = {3, 4.5, 6}; // s
+const double SHOT_ENERGY = 0.15;
+const double END = 7.5;
+
+const FlywheelPlantSetup MISMATCHED_PLANT = {{0.06, 0.2}, {0.04, 0.15}, {1, 0.9}, 12600, 0, 1, nullptr};
+
+ScenarioResult runScenario(FlywheelControl control, const FlywheelPlantSetup& setup, FILE* csv) {
+	DualFlywheelSimulator plant;
+	plant.setStaticFriction(setup.static_friction[0], setup.static_friction[1]);
+	plant.setDynamicFriction(setup.dynamic_friction[0], setup.dynamic_friction[1]);
+	plant.setStrength(setup.strength[0], setup.strength[1]);
+	plant.setBattery(setup.battery_mv);
+	double shot_energy = SHOT_ENERGY;
+	if (setup.model != nullptr) {
+		plant.setModel(*setup.model);
+		shot_energy = setup.model->shot_energy;
+	}
+	int steps = (int)std::lround(SCENARIO_TICK / plant.getTimestep());
+
+	std::mt19937 rng(setup.seed);
+	std::normal_distribution<double> noise(0, setup.noise_rpm > 0 ? setup.noise_rpm : 1);
+
+	const double target = SCENARIO_TARGET;
+	ScenarioResult result = {-1, 0, 0, 0, 0, {-1, -1, -1}, 0};
+	int next_shot = 0;
+	double last_shot = -1;
+	double last_mv1 = 0, last_mv2 = 0;
+	int ticks = 0;
+	for (int tick = 0; tick * SCENARIO_TICK < END; tick++) {
+		double t = tick * SCENARIO_TICK;
+		if (next_shot < SCENARIO_SHOTS && t >= SHOTS[next_shot]) {
+			plant.shoot(shot_energy);
+			last_shot = t;
+			next_shot++;
+		}
+
+		double rpm1 = plant.getRpm1(), rpm2 = plant.getRpm2();
+		double read1 = rpm1, read2 = rpm2;
+		if (setup.noise_rpm > 0) {
+			read1 += noise(rng);
+			read2 += noise(rng);
+		}
+		double mv1, mv2;
+		control(read1, read2, mv1, mv2);
+		plant.setVoltage(mv1, mv2);
+		for (int i = 0; i < steps; i++) {
+			plant.step();
+		}
+		if (csv) {
+			fprintf(csv, "%.2f,%.1f,%.1f,%.0f,%.0f\n", t, rpm1, rpm2, mv1, mv2);
+		}
+
+		result.chatter += (std::fabs(mv1 - last_mv1) + std::fabs(mv2 - last_mv2)) / 2;
+		last_mv1 = mv1;
+		last_mv2 = mv2;
+		ticks++;
+
+		double average = (rpm1 + rpm2) / 2;
+		result.peak_difference = std::max(result.peak_difference, std::fabs(rpm1 - rpm2));
+		bool in_band = std::fabs(rpm1 - target) < target * 0.05 && std::fabs(rpm2 - target) < target * 0.05;
+		if (result.rise < 0 && std::fabs(average - target) < target * 0.05) {
+			result.rise = t;
+		}
+		if (next_shot == 0 && average - target > result.overshoot) {
+			result.overshoot = average - target;
+		}
+		if (next_shot == 0 && t >= SHOTS[0] - 0.5) {
+			// average over the half second before the first shot
+			result.difference += std::fabs(rpm1 - rpm2) / 50;
+			result.error += std::fabs(average - target) / 50;
+		}
+		if (next_shot > 0 && result.recovery[next_shot - 1] < 0 && in_band && t > last_shot) {
+			result.recovery[next_shot - 1] = t - last_shot;
+		}
+	}
+	result.chatter /= ticks;
+	return result;
+}
+
+ScenarioResult runController(const FlywheelGains& gains, const FlywheelPlantSetup& setup, bool compensate, FILE* csv) {
+	BatteryCompensation battery;
+	battery.update(setup.battery_mv);
+	DualFlywheel flywheel(gains);
+	flywheel.setTarget(SCENARIO_TARGET);
+	flywheel.setFeedforwardScale(compensate ? battery.getScale() : 1);
+	return runScenario([&](double rpm1, double rpm2, double& mv1, double& mv2) {
+		flywheel.update(rpm1, rpm2, SCENARIO_TICK);
+		mv1 = flywheel.getVoltage1();
+		mv2 = flywheel.getVoltage2();
+	}, setup, csv);
+}
+
+void printResult(const char* name, const ScenarioResult& r) {
+	printf("%-12s rise %5.2f s  overshoot %4.1f  difference %4.1f (peak %4.1f)  error %4.1f rpm  recovery", name,
+	       r.rise, r.overshoot, r.difference, r.peak_difference, r.error);
+	for (double recovery : r.recovery) {
+		if (recovery < 0) {
+			printf("  never");
+		}
+		else {
+			printf(" %5.2f", recovery);
+		}
+	}
+	printf(" s\n");
+}
+
+bool loadFlywheelModel(const char* path, FlywheelModel& model) {
+	FILE* file = fopen(path, "r");
+	if (file == nullptr) {
+		return false;
+	}
+	int read = fscanf(file, "%lf %lf %lf %lf %lf %lf %lf", &model.kS[0], &model.kV[0], &model.kA[0], &model.kS[1],
+	                  &model.kV[1], &model.kA[1], &model.shot_energy);
+	fclose(file);
+	return read == 7;
+}
+
+bool saveFlywheelModel(const char* path, const FlywheelModel& model) {
+	FILE* file = fopen(path, "w");
+	if (file == nullptr) {
+		return false;
+	}
+	fprintf(file, "%.3f %.4f %.4f\n%.3f %.4f %.4f\n%.4f\n", model.kS[0], model.kV[0], model.kA[0], model.kS[1],
+	        model.kV[1], model.kA[1], model.shot_energy);
+	fclose(file);
+	return true;
+}
@@ -0,0 +1,53 @@
+// The flywheel test both host flywheel tools use: spin up to 150 rpm, hold,
+// then three shots 1.5 s apart, on a two-motor plant whose friction, motor
+// strength, battery and speed-sensor noise can be set per run.
+
+#ifndef FLYWHEEL_SCENARIO_H
+#define FLYWHEEL_SCENARIO_H
+
+#include "DualFlywheel.h"
+#include <cstdio>
+#include <functional>
+
+const double SCENARIO_TARGET = 150; // rpm
+const double SCENARIO_TICK = 0.01;  // controller period, s
+const int SCENARIO_SHOTS = 3;
+
+struct FlywheelPlantSetup {
+	double static_friction[2];  // N m
+	double dynamic_friction[2];
+	double strength[2];
+	double battery_mv;
+	double noise_rpm;           // spread of each speed reading
+	unsigned seed;
+	const FlywheelModel* model; // fitted plant instead of the friction and strength above, or null
+};
+
+// motor 2 drags more and is a bit weaker, as the LCD shows on the robot
+extern const FlywheelPlantSetup MISMATCHED_PLANT;
+
+struct ScenarioResult {
+	double rise;                       // s to get the average within 5 %, -1 never
+	double overshoot;                  // rpm past the target on the way up
+	double difference;                 // rpm between the motors, steady state before the first shot
+	double peak_difference;            // largest rpm between the motors over the run, spin-up and shots included
+	double error;                      // average rpm off target, same time
+	double recovery[SCENARIO_SHOTS];   // s until both motors are back within 5 %, -1 never
+	double chatter;                    // mean change of the motor voltages per tick, mV
+};
+
+// control(rpm1, rpm2, mv1, mv2) is called every SCENARIO_TICK
+typedef std::function<void(double, double, double&, double&)> FlywheelControl;
+
+ScenarioResult runScenario(FlywheelControl control, const FlywheelPlantSetup& setup, FILE* csv = nullptr);
+// the robot's controller, with battery compensation as in the flywheel task
+ScenarioResult runController(const FlywheelGains& gains, const FlywheelPlantSetup& setup, bool compensate = true,
+                             FILE* csv = nullptr);
+
+void printResult(const char* name, const ScenarioResult& result);
+
+// model files as written by flywheel_fit: kS, kV, kA for each motor and the shot energy
+bool loadFlywheelModel(const char* path, FlywheelModel& model);
+bool saveFlywheelModel(const char* path, const FlywheelModel& model);
+
+#endif
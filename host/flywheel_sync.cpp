@@ -0,0 +1,78 @@
+// Runs the two-motor flywheel simulator with mismatched motors and compares
+// two independent PI velocity loops (what move_velocity() does) against the
+// cross-coupled DualFlywheel controller: spin-up, the rpm difference between
+// the motors, and recovery after three shots. Then runs the controller on a
+// full and a depleted battery, with and without battery compensation.
+// usage: flywheel_sync [kP kI kP_diff kI_diff] [--csv] [--model file]
+
+#include "flywheel_scenario.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char** argv) {
+	FlywheelGains gains = DEFAULT_FLYWHEEL_GAINS;
+	FlywheelPlantSetup plant = MISMATCHED_PLANT;
+	FlywheelModel model;
+	bool csv = false;
+	double* tunable[] = {&gains.kP, &gains.kI, &gains.kP_diff, &gains.kI_diff};
+	int n = 0;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--csv") == 0) {
+			csv = true;
+		}
+		else if (strcmp(argv[i], "--model") == 0 && i + 1 < argc) {
+			if (!loadFlywheelModel(argv[++i], model)) {
+				fprintf(stderr, "can't read model %s\n", argv[i]);
+				return 1;
+			}
+			plant.model = &model;
+		}
+		else if (n < 4) {
+			*tunable[n++] = atof(argv[i]);
+		}
+	}
+
+	if (csv) {
+		runController(gains, plant, true, stdout);
+		return 0;
+	}
+
+	// each motor's own PI velocity loop, as move_velocity() runs it, with the
+	// same gains and anti-windup as the coupled average loop but knowing
+	// nothing about the other motor
+	const double target = SCENARIO_TARGET;
+	double integral[2] = {0, 0};
+	auto motorLoop = [&](int motor, double rpm, double kS) {
+		double error = target - rpm;
+		double out = gains.kV * target + kS + gains.kP * error + gains.kI * integral[motor];
+		if (std::fabs(out) < 12000 || error * out < 0) {
+			integral[motor] += error * SCENARIO_TICK;
+		}
+		return std::clamp(out, -12000.0, 12000.0);
+	};
+	ScenarioResult independent = runScenario([&](double rpm1, double rpm2, double& mv1, double& mv2) {
+		mv1 = motorLoop(0, rpm1, gains.kS1);
+		mv2 = motorLoop(1, rpm2, gains.kS2);
+	}, plant);
+	ScenarioResult coupled = runController(gains, plant);
+
+	printf("gains kP %.0f kI %.0f kP_diff %.0f kI_diff %.0f\n", gains.kP, gains.kI, gains.kP_diff, gains.kI_diff);
+	printResult("independent", independent);
+	printResult("coupled", coupled);
+
+	printf("\nbattery\n");
+	const double batteries[] = {12600, 11400};
+	for (double battery_mv : batteries) {
+		FlywheelPlantSetup setup = plant;
+		setup.battery_mv = battery_mv;
+		for (int compensate = 0; compensate < 2; compensate++) {
+			char name[32];
+			snprintf(name, sizeof(name), "%.1f V %s", battery_mv / 1000, compensate ? "comp" : "raw");
+			printResult(name, runController(gains, setup, compensate));
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,185 @@
+// Tunes the DualFlywheel loop gains offline with a particle swarm, the same
+// optimizer okapi::PIDTuner runs on the robot, but against simulated plants
+// so each candidate costs milliseconds instead of seconds of motor time.
+// Each candidate is scored on spin-up, overshoot, motor difference and shot
+// recovery over several plants (mismatched motors, a flat battery, a noisy
+// speed sensor), and the candidates of each iteration are evaluated in
+// parallel. With --model the plants use the model flywheel_fit identified
+// from the robot. Prints the gains ready to paste over DEFAULT_FLYWHEEL_GAINS.
+// usage: flywheel_tune [particles] [iterations] [threads] [--model file]
+
+#include "flywheel_scenario.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+const int DIMENSIONS = 4; // kP, kI, kP_diff, kI_diff
+const double LOWER[DIMENSIONS] = {0, 0, 0, 0};
+const double UPPER[DIMENSIONS] = {200, 4000, 200, 4000};
+
+// swarm constants, okapi::PIDTuner uses the same kind of update
+const double INERTIA = 0.7;
+const double PERSONAL = 1.5;
+const double SOCIAL = 1.5;
+
+FlywheelGains toGains(const double* position) {
+	FlywheelGains gains = DEFAULT_FLYWHEEL_GAINS;
+	gains.kP = position[0];
+	gains.kI = position[1];
+	gains.kP_diff = position[2];
+	gains.kI_diff = position[3];
+	return gains;
+}
+
+std::vector<FlywheelPlantSetup> plants(const FlywheelModel* model) {
+	std::vector<FlywheelPlantSetup> setups;
+	FlywheelPlantSetup mismatched = MISMATCHED_PLANT;
+	mismatched.noise_rpm = 3;
+	setups.push_back(mismatched);
+
+	FlywheelPlantSetup flat = mismatched;
+	flat.battery_mv = 11400;
+	flat.seed = 2;
+	setups.push_back(flat);
+
+	FlywheelPlantSetup balanced = {{0.05, 0.05}, {0.03, 0.03}, {1, 1}, 12600, 3, 3, nullptr};
+	setups.push_back(balanced);
+
+	FlywheelPlantSetup reversed = {{0.2, 0.06}, {0.15, 0.04}, {0.85, 1}, 12200, 3, 4, nullptr};
+	setups.push_back(reversed);
+
+	if (model != nullptr) {
+		// the fitted plant under each battery and noise condition
+		for (FlywheelPlantSetup& setup : setups) {
+			setup.model = model;
+		}
+	}
+	return setups;
+}
+
+// lower is better; seconds of spin-up and recovery plus penalties
+double cost(const ScenarioResult& result) {
+	double total = result.rise < 0 ? 3 : result.rise;
+	for (double recovery : result.recovery) {
+		total += 2.0 / SCENARIO_SHOTS * (recovery < 0 ? 1.5 : recovery);
+	}
+	total += 5 * result.overshoot / SCENARIO_TARGET;
+	total += (result.difference + result.error) / 20;
+	total += result.chatter / 1000; // noisy voltage heats the motors
+	return total;
+}
+
+double evaluate(const double* position, const std::vector<FlywheelPlantSetup>& setups) {
+	FlywheelGains gains = toGains(position);
+	double total = 0;
+	for (const FlywheelPlantSetup& setup : setups) {
+		total += cost(runController(gains, setup));
+	}
+	return total / setups.size();
+}
+
+struct Particle {
+	double position[DIMENSIONS];
+	double velocity[DIMENSIONS];
+	double best[DIMENSIONS];
+	double best_cost;
+	double cost;
+};
+
+int main(int argc, char** argv) {
+	FlywheelModel model;
+	bool fitted = false;
+	std::vector<int> numbers;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--model") == 0 && i + 1 < argc) {
+			fitted = loadFlywheelModel(argv[++i], model);
+			if (!fitted) {
+				fprintf(stderr, "can't read model %s\n", argv[i]);
+				return 1;
+			}
+		}
+		else {
+			numbers.push_back(atoi(argv[i]));
+		}
+	}
+	int particles = numbers.size() > 0 ? numbers[0] : 32;
+	int iterations = numbers.size() > 1 ? numbers[1] : 40;
+	int threads = numbers.size() > 2 ? numbers[2] : (int)std::thread::hardware_concurrency();
+	if (threads < 1) {
+		threads = 1;
+	}
+	std::vector<FlywheelPlantSetup> setups = plants(fitted ? &model : nullptr);
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<double> unit(0, 1);
+	std::vector<Particle> swarm(particles);
+	for (int p = 0; p < particles; p++) {
+		for (int d = 0; d < DIMENSIONS; d++) {
+			swarm[p].position[d] = LOWER[d] + unit(rng) * (UPPER[d] - LOWER[d]);
+			swarm[p].velocity[d] = (unit(rng) - 0.5) * (UPPER[d] - LOWER[d]) * 0.2;
+		}
+		swarm[p].best_cost = INFINITY;
+	}
+	// the current defaults start in the swarm so the result is never worse
+	const FlywheelGains& start = DEFAULT_FLYWHEEL_GAINS;
+	double defaults[DIMENSIONS] = {start.kP, start.kI, start.kP_diff, start.kI_diff};
+	std::copy(defaults, defaults + DIMENSIONS, swarm[0].position);
+
+	double global_best[DIMENSIONS];
+	double global_cost = INFINITY;
+	for (int iteration = 0; iteration < iterations; iteration++) {
+		std::vector<std::thread> workers;
+		for (int t = 0; t < threads; t++) {
+			workers.emplace_back([&, t] {
+				for (int p = t; p < particles; p += threads) {
+					swarm[p].cost = evaluate(swarm[p].position, setups);
+				}
+			});
+		}
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+
+		for (Particle& particle : swarm) {
+			if (particle.cost < particle.best_cost) {
+				particle.best_cost = particle.cost;
+				std::copy(particle.position, particle.position + DIMENSIONS, particle.best);
+			}
+			if (particle.cost < global_cost) {
+				global_cost = particle.cost;
+				std::copy(particle.position, particle.position + DIMENSIONS, global_best);
+			}
+		}
+		printf("iteration %2d  best cost %.4f  kP %.1f kI %.1f kP_diff %.1f kI_diff %.1f\n", iteration, global_cost,
+		       global_best[0], global_best[1], global_best[2], global_best[3]);
+
+		// serial so the swarm moves the same way whatever the thread count
+		for (Particle& particle : swarm) {
+			for (int d = 0; d < DIMENSIONS; d++) {
+				particle.velocity[d] = INERTIA * particle.velocity[d]
+					+ PERSONAL * unit(rng) * (particle.best[d] - particle.position[d])
+					+ SOCIAL * unit(rng) * (global_best[d] - particle.position[d]);
+				particle.position[d] = std::clamp(particle.position[d] + particle.velocity[d], LOWER[d], UPPER[d]);
+			}
+		}
+	}
+
+	printf("\nstarting gains, cost %.4f\n", evaluate(defaults, setups));
+	printResult("  mismatched", runController(DEFAULT_FLYWHEEL_GAINS, setups[0]));
+	printResult("  flat", runController(DEFAULT_FLYWHEEL_GAINS, setups[1]));
+	FlywheelGains best = toGains(global_best);
+	printf("tuned gains, cost %.4f\n", global_cost);
+	printResult("  mismatched", runController(best, setups[0]));
+	printResult("  flat", runController(best, setups[1]));
+
+	printf("\nconst FlywheelGains DEFAULT_FLYWHEEL_GAINS = {\n");
+	printf("\t%.0f,  // kV\n\t%.0f, // kS1\n\t%.0f, // kS2\n", best.kV, best.kS1, best.kS2);
+	printf("\t%.0f,  // kP\n\t%.0f, // kI\n\t%.0f,  // kP_diff\n\t%.0f, // kI_diff\n};\n", best.kP, best.kI,
+	       best.kP_diff, best.kI_diff);
+	return 0;
+}
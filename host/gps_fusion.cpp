@@ -0,0 +1,79 @@
+// Checks the GPS/odometry fusion against a simulated run.
+// The robot drives laps of a square while the wheels slip a little, gets
+// shoved sideways part way through, and the fused pose is compared with the
+// odometry-only pose against the truth.
+// usage: gps_fusion [seed]
+
+#include "Localization.h"
+#include "HeadingHold.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+int main(int argc, char** argv) {
+	unsigned seed = argc > 1 ? atoi(argv[1]) : 1;
+	std::mt19937 rng(seed);
+	std::normal_distribution<double> slip(1, 0.03);
+
+	const double dt = 0.01;
+	const double speed = 30;    // in/s
+	const int gps_every = 5;    // ticks, 20 Hz
+	const double shove_time = 6;
+
+	Pose truth = {-36, -36, 0};
+	Pose odom_only = truth;
+	Localization fused;
+	fused.reset(truth);
+	SimulatedGps gps(0.8, 0.05, 0.02, seed);
+
+	double odom_sq = 0, fused_sq = 0;
+	int samples = 0;
+	for (int tick = 0; tick < 1500; tick++) {
+		double t = tick * dt;
+		// strafe around a 72 in square, one side every 2.4 s, heading fixed
+		int side = (int)(t * speed / 72) % 4;
+		double field_dx = side == 0 ? speed : side == 2 ? -speed : 0;
+		double field_dy = side == 1 ? speed : side == 3 ? -speed : 0;
+		truth.x += field_dx * dt;
+		truth.y += field_dy * dt;
+		truth.heading = 10 * std::sin(t);
+
+		// robot-frame displacement as the wheels measure it
+		double h = truth.heading * M_PI / 180;
+		double forward = (field_dx * std::sin(h) + field_dy * std::cos(h)) * dt * slip(rng);
+		double right = (field_dx * std::cos(h) - field_dy * std::sin(h)) * dt * slip(rng);
+
+		if (std::fabs(t - shove_time) < dt / 2) {
+			truth.x += 10; // collision, the wheels never see it
+			printf("t=%.2f shoved 10 in\n", t);
+		}
+
+		double mid = h;
+		odom_only.x += right * std::cos(mid) + forward * std::sin(mid);
+		odom_only.y += forward * std::cos(mid) - right * std::sin(mid);
+
+		fused.predict(forward, right, truth.heading);
+		if (tick % gps_every == 0) {
+			fused.correct(gps.read(truth));
+		}
+
+		Pose estimate = fused.getPose();
+		odom_sq += std::pow(odom_only.x - truth.x, 2) + std::pow(odom_only.y - truth.y, 2);
+		fused_sq += std::pow(estimate.x - truth.x, 2) + std::pow(estimate.y - truth.y, 2);
+		samples++;
+
+		if (tick % 100 == 0) {
+			printf("t=%5.2f odom err %6.2f fused err %6.2f sigma %5.2f\n", t,
+			       std::hypot(odom_only.x - truth.x, odom_only.y - truth.y),
+			       std::hypot(estimate.x - truth.x, estimate.y - truth.y), fused.getStdDev());
+		}
+	}
+
+	Pose estimate = fused.getPose();
+	printf("rms error: odometry %.2f in, fused %.2f in\n", std::sqrt(odom_sq / samples), std::sqrt(fused_sq / samples));
+	printf("final error: odometry %.2f in, fused %.2f in\n", std::hypot(odom_only.x - truth.x, odom_only.y - truth.y),
+	       std::hypot(estimate.x - truth.x, estimate.y - truth.y));
+	printf("fixes accepted %lu rejected %lu\n", (unsigned long)fused.getAccepted(), (unsigned long)fused.getRejected());
+	return 0;
+}
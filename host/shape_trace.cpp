@@ -0,0 +1,43 @@
+// Replays a recorded stick trace through a driver profile.
+// usage: shape_trace <profile name> < trace.csv > shaped.csv
+// input lines:  time_ms,x,y,r
+// output lines: time_ms,x,y,r,shaped_x,shaped_y,shaped_r
+
+#include "InputShaping.h"
+#include <cstdio>
+#include <cstring>
+
+int main(int argc, char** argv) {
+	const DriverProfile* profile = &DRIVER_PROFILES[0];
+	if (argc > 1) {
+		profile = nullptr;
+		for (int i = 0; i < NUM_DRIVER_PROFILES; i++) {
+			if (strcmp(argv[1], DRIVER_PROFILES[i].name) == 0) {
+				profile = &DRIVER_PROFILES[i];
+			}
+		}
+		if (profile == nullptr) {
+			fprintf(stderr, "unknown profile '%s', options are:\n", argv[1]);
+			for (int i = 0; i < NUM_DRIVER_PROFILES; i++) {
+				fprintf(stderr, "  %s\n", DRIVER_PROFILES[i].name);
+			}
+			return 1;
+		}
+	}
+
+	InputShaper shaper(*profile);
+	char line[256];
+	double t, x, y, r;
+	double last_t = -1;
+	printf("time_ms,x,y,r,shaped_x,shaped_y,shaped_r\n");
+	while (fgets(line, sizeof(line), stdin)) {
+		if (sscanf(line, "%lf,%lf,%lf,%lf", &t, &x, &y, &r) != 4) {
+			continue; // header or comment
+		}
+		double dt = last_t < 0 ? 0 : (t - last_t) / 1000.0;
+		last_t = t;
+		shaper.update(x, y, r, dt);
+		printf("%.0f,%.0f,%.0f,%.0f,%.2f,%.2f,%.2f\n", t, x, y, r, shaper.getX(), shaper.getY(), shaper.getR());
+	}
+	return 0;
+}
@@ -0,0 +1,45 @@
+#ifndef AIM_ASSIST_H
+#define AIM_ASSIST_H
+
+#include <cstdint>
+
+// Rotate-to-goal loop used while the aim button is held.
+// A stiffer PD on heading than HeadingHold, plus settle detection: the
+// indexer is only allowed to fire once the heading has stayed within the
+// tolerance, with the robot no longer turning, for settle_ms.
+
+class AimAssist {
+public:
+	AimAssist(double tolerance = 2, double kP = 3.5, double kD = 0.25, double max_output = 100,
+	          double kS = 8, uint32_t settle_ms = 100, double settle_rate = 15);
+
+	// target and heading in degrees, returns the rotation command
+	double update(double target, double heading, uint32_t now);
+	void reset();
+
+	bool isSettled() const;
+	double getError() const;
+
+private:
+	double tolerance;
+	double kP;
+	double kD;
+	double max_output;
+	double kS; // static friction feedforward, keeps small errors from stalling
+	uint32_t settle_ms;
+	double settle_rate;
+
+	bool has_last = false;
+	double last_heading = 0;
+	uint32_t last_time = 0;
+	double rate = 0;
+	double error = 0;
+	bool in_tolerance = false;
+	uint32_t in_tolerance_since = 0;
+	bool settled = false;
+};
+
+// bearing in degrees (clockwise from +y) from one field point to another
+double bearingTo(double from_x, double from_y, double to_x, double to_y);
+
+#endif
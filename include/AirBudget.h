@@ -0,0 +1,44 @@
+#ifndef AIR_BUDGET_H
+#define AIR_BUDGET_H
+
+#include <cstdint>
+
+// Estimates the air left for the indexer piston.
+// Every stroke lets the tank air mix with the atmospheric air already in the
+// vented cylinder. Isothermally P' = (P V + P_atm v) / (V + v), which is the
+// gauge pressure dropping by the ratio of the two volumes. The piston moves slower at lower
+// pressure, so the dwell before retracting grows as 1/sqrt(pressure).
+
+struct AirTank {
+	double tank_ml;        // all reservoirs together
+	double start_psi;      // gauge pressure after pumping up
+	double extend_ml;      // cylinder volume filled on extend
+	double retract_ml;     // filled on retract, 0 for a spring return
+	double min_psi;        // below this the piston no longer fires a disc
+	uint32_t full_dwell_ms; // dwell that reliably fires at start_psi
+	uint32_t max_dwell_ms;
+};
+
+class AirBudget {
+public:
+	AirBudget(const AirTank& tank);
+
+	// call on every change of the piston output
+	void recordActuation(bool extended);
+	void reset();
+
+	double getPressure() const; // gauge psi
+	uint32_t getActuations() const;
+	// extend strokes left before the pressure falls below min_psi
+	int getShotsLeft() const;
+	bool isLow() const;
+	// time to hold the piston out at the current pressure
+	uint32_t getDwell() const;
+
+private:
+	AirTank tank;
+	double pressure; // gauge psi
+	uint32_t actuations = 0;
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef BATTERY_COMPENSATION_H
+#define BATTERY_COMPENSATION_H
+
+// Scales voltage commands for the battery charge.
+// Feedforward gains are tuned on a full battery; as the battery sags the same
+// command gives less torque. The battery voltage is low-pass filtered (it
+// dips with every current spike) and commands are multiplied by
+// reference / battery, within limits.
+
+class BatteryCompensation {
+public:
+	// voltages in mV, filter is the weight of each new reading
+	BatteryCompensation(double reference_mv = 12600, double max_scale = 1.25, double filter = 0.05);
+
+	// readings that are not positive (sensor error) are ignored
+	void update(double battery_mv);
+	double getVoltage() const;
+	double getScale() const;
+
+private:
+	double reference_mv;
+	double max_scale;
+	double filter;
+	double voltage = 0;
+};
+
+#endif
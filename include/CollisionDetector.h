@@ -0,0 +1,64 @@
+#ifndef COLLISION_DETECTOR_H
+#define COLLISION_DETECTOR_H
+
+#include <cstdint>
+
+// Contact detection for the drive.
+// Two signatures: an impact shows as a spike in IMU jerk (the chassis
+// acceleration changing faster than any planned move changes it), and
+// pushing against something shows as drive current near the limit while the
+// wheels hardly turn, or as the wheels losing traction (TractionMonitor) for
+// longer than a hard start would. Either one starts a contact, which is held for
+// hold_ms after the last sign of it so a condition polled at the command
+// tick cannot miss it. The impact direction is kept for logging and replanning.
+
+enum ContactType {
+	CONTACT_NONE,
+	CONTACT_IMPACT,  // sudden stop or knock
+	CONTACT_PUSHING  // wheels stalled against something
+};
+
+class CollisionDetector {
+public:
+	// jerk in g/s, current in mA, stall speed in motor rpm
+	CollisionDetector(double jerk_threshold = 15, double stall_current = 1800, double stall_rpm = 15,
+	                  double slip_traction = 0.5, uint32_t stall_ms = 100, uint32_t hold_ms = 150);
+
+	// accel_forward, accel_right: IMU acceleration in the robot frame (g),
+	// current: drive motor draw (mA), rpm: drive motor speed, fl..br,
+	// traction: from TractionMonitor
+	ContactType update(double accel_forward, double accel_right, const double current[4], const double rpm[4],
+	                   double traction, uint32_t now);
+	void reset();
+
+	// latest contact, held for hold_ms; CONTACT_NONE when clear
+	ContactType getContact() const;
+	bool inContact() const;
+	// direction the hit came from in the robot frame, degrees clockwise from
+	// forward (0 is a hit on the front)
+	double getImpactDirection() const;
+	double getJerk() const; // g/s, filtered
+	uint32_t getContacts() const;
+
+private:
+	double jerk_threshold;
+	double stall_current;
+	double stall_rpm;
+	double slip_traction;
+	uint32_t stall_ms;
+	uint32_t hold_ms;
+
+	bool has_last = false;
+	double last_forward = 0;
+	double last_right = 0;
+	uint32_t last_time = 0;
+	double jerk = 0;
+	bool stalling = false;
+	uint32_t stall_since = 0;
+	ContactType contact = CONTACT_NONE;
+	uint32_t contact_time = 0;
+	double impact_direction = 0;
+	uint32_t contacts = 0;
+};
+
+#endif
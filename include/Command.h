@@ -0,0 +1,200 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Command framework for autonomous.
+// A command is started once, updated every scheduler tick until it reports it
+// is finished, and can be cancelled part way. Groups run their children
+// sequentially, in parallel, as a race (first to finish wins) or against a
+// deadline (the first child decides when the group ends). Time is passed in
+// by the caller so the same graph runs on the robot and on a computer.
+// A guard watches a condition while its child runs and swaps in a recovery
+// when the condition trips.
+
+struct CommandTiming {
+	std::string name;
+	int depth;
+	bool ran;
+	bool interrupted;
+	uint32_t start; // ms
+	uint32_t end;   // ms
+};
+
+class Command {
+public:
+	Command(const std::string& name);
+	virtual ~Command() = default;
+
+	void start(uint32_t now);
+	// returns true once the command has finished
+	bool update(uint32_t now);
+	void cancel(uint32_t now);
+
+	bool isRunning() const;
+	bool hasRun() const;
+	const std::string& getName() const;
+
+	// appends the timing of this command and its children, in tree order
+	virtual void collectTimings(std::vector<CommandTiming>& out, int depth = 0) const;
+
+protected:
+	virtual void initialize() {}
+	virtual void execute() {}
+	virtual bool isFinished() { return true; }
+	virtual void end(bool) {}
+
+	// time of the current tick, and time since this command started
+	uint32_t time() const;
+	uint32_t elapsed() const;
+
+	std::string name;
+
+private:
+	bool running = false;
+	bool ran = false;
+	bool interrupted = false;
+	uint32_t now_time = 0;
+	uint32_t start_time = 0;
+	uint32_t end_time = 0;
+};
+
+typedef std::unique_ptr<Command> CommandPtr;
+
+// runs callbacks; any of them may be empty. is_finished gets the ms since start,
+// an empty is_finished finishes straight away
+class FunctionCommand : public Command {
+public:
+	FunctionCommand(const std::string& name, std::function<void()> on_start,
+	                std::function<void()> on_execute = nullptr,
+	                std::function<bool(uint32_t)> is_finished = nullptr,
+	                std::function<void(bool)> on_end = nullptr);
+
+protected:
+	void initialize() override;
+	void execute() override;
+	bool isFinished() override;
+	void end(bool interrupted) override;
+
+private:
+	std::function<void()> on_start;
+	std::function<void()> on_execute;
+	std::function<bool(uint32_t)> is_finished;
+	std::function<void(bool)> on_end;
+};
+
+class WaitCommand : public Command {
+public:
+	WaitCommand(uint32_t ms);
+
+protected:
+	bool isFinished() override;
+
+private:
+	uint32_t ms;
+};
+
+// waits for a condition on sensor state, timeout_ms 0 waits forever
+class WaitUntilCommand : public Command {
+public:
+	WaitUntilCommand(const std::string& name, std::function<bool()> condition, uint32_t timeout_ms = 0);
+
+protected:
+	bool isFinished() override;
+
+private:
+	std::function<bool()> condition;
+	uint32_t timeout_ms;
+};
+
+class CommandGroup : public Command {
+public:
+	CommandGroup(const std::string& name, std::vector<CommandPtr> commands);
+	void collectTimings(std::vector<CommandTiming>& out, int depth = 0) const override;
+
+protected:
+	void end(bool interrupted) override;
+	std::vector<CommandPtr> commands;
+};
+
+class SequentialGroup : public CommandGroup {
+public:
+	SequentialGroup(std::vector<CommandPtr> commands, const std::string& name = "sequence");
+
+protected:
+	void initialize() override;
+	void execute() override;
+	bool isFinished() override;
+
+private:
+	size_t current = 0;
+};
+
+// runs every child and finishes when all of them have
+class ParallelGroup : public CommandGroup {
+public:
+	ParallelGroup(std::vector<CommandPtr> commands, const std::string& name = "parallel");
+
+protected:
+	void initialize() override;
+	void execute() override;
+	bool isFinished() override;
+
+private:
+	bool done = false;
+};
+
+// finishes as soon as any child does, the rest are cancelled
+class RaceGroup : public CommandGroup {
+public:
+	RaceGroup(std::vector<CommandPtr> commands, const std::string& name = "race");
+
+protected:
+	void initialize() override;
+	void execute() override;
+	bool isFinished() override;
+
+private:
+	bool done = false;
+};
+
+// finishes when the first child does, the rest are cancelled
+class DeadlineGroup : public CommandGroup {
+public:
+	DeadlineGroup(std::vector<CommandPtr> commands, const std::string& name = "deadline");
+
+protected:
+	void initialize() override;
+	void execute() override;
+	bool isFinished() override;
+
+private:
+	bool done = false;
+};
+
+// runs the first child; if the condition turns true before it finishes, the
+// child is cancelled and the second (if any) runs in its place, e.g. to back
+// off and replan after bumping into something
+class GuardCommand : public CommandGroup {
+public:
+	GuardCommand(const std::string& condition_name, std::function<bool()> condition, CommandPtr body,
+	             CommandPtr recovery = nullptr);
+
+	bool wasTripped() const;
+
+protected:
+	void initialize() override;
+	void execute() override;
+	bool isFinished() override;
+
+private:
+	std::function<bool()> condition;
+	bool tripped = false;
+	bool done = false;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef CURRENT_BUDGET_H
+#define CURRENT_BUDGET_H
+
+#include "api.h"
+#include "Subsystem.h"
+#include <vector>
+
+// Shares the brain's total motor current between subsystems.
+// Every tick the draw of each registered motor is read, each motor is given a
+// limit slightly above what it is using now, and when the total would exceed
+// the budget the lower-priority subsystems are the ones that get cut. This
+// replaces the brain's own even derating, which sags the flywheel whenever the
+// drive accelerates.
+
+class CurrentBudget {
+public:
+	// currents are in mA
+	CurrentBudget(int total_ma = 20000, int motor_max_ma = 2500, int motor_min_ma = 500);
+
+	void addMotor(pros::Motor* motor, Subsystem subsystem);
+
+	// puts one subsystem first, the others keep the default drive, flywheel,
+	// intake order
+	void setPriority(Subsystem first);
+	Subsystem getPriority() const;
+
+	// reads the current draws and applies new limits
+	void update();
+	// runs update() every period_ms in a background task
+	void start(uint32_t period_ms = 10);
+
+	bool isLimited(Subsystem subsystem) const;
+	uint32_t getLimitedTicks(Subsystem subsystem) const;
+
+private:
+	struct Entry {
+		pros::Motor* motor;
+		Subsystem subsystem;
+		int demand;
+		int limit;
+		int applied;
+	};
+
+	int total_ma;
+	int motor_max_ma;
+	int motor_min_ma;
+	std::vector<Entry> motors;
+	Subsystem first = SUBSYSTEM_DRIVE; // written by the control loop, read by the budget task
+	bool limited[NUM_SUBSYSTEMS] = {};
+	uint32_t limited_ticks[NUM_SUBSYSTEMS] = {};
+	uint32_t last_report = 0;
+	pros::Task* task = nullptr;
+};
+
+#endif
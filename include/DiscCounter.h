@@ -0,0 +1,49 @@
+#ifndef DISC_COUNTER_H
+#define DISC_COUNTER_H
+
+#include <cstdint>
+
+// Counts the discs in the robot from two distance sensors: one across the
+// intake mouth and one looking at the disc seated in front of the indexer.
+// A disc passing the intake sensor adds one (or takes one away when the
+// intake is spitting discs out), a shot with a seated disc takes one away.
+// Distances are in mm, pass a negative distance when a sensor is missing.
+
+const int MAX_DISCS = 3;
+
+class DiscCounter {
+public:
+	DiscCounter(int intake_threshold = 60, int indexer_threshold = 50, uint32_t debounce_ms = 20);
+
+	// intake_direction: sign of the intake command, 0 when stopped
+	void update(int intake_mm, int indexer_mm, int intake_direction, uint32_t now);
+
+	// true when a shot would launch a disc; without sensors it always is
+	bool canFire() const;
+	// call when the piston fires, returns false for a dry fire
+	bool recordShot();
+
+	int getCount() const;
+	bool hasSensors() const;
+	void setCount(int count);
+
+private:
+	struct Beam {
+		bool present = false;
+		bool raw = false;
+		uint32_t changed = 0;
+		bool valid = false;
+	};
+	// returns true on a debounced blocked edge
+	bool updateBeam(Beam& beam, int mm, int threshold, uint32_t now);
+
+	int intake_threshold;
+	int indexer_threshold;
+	uint32_t debounce_ms;
+
+	Beam intake;
+	Beam indexer;
+	int count = 0;
+};
+
+#endif
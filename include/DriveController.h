@@ -0,0 +1,77 @@
+#ifndef DRIVE_CONTROLLER_H
+#define DRIVE_CONTROLLER_H
+
+#include "MotionProfile.h"
+#include <cstdint>
+
+// Straight-line autonomous moves for the x-drive, in any direction.
+// The move follows a jerk-limited profile along the line with velocity and
+// acceleration feedforward, so the wheels spin up no faster than they can
+// grip. Progress along the line comes from the drive encoders (the Odometry
+// kinematics) with a PD loop against the profile; drift across the line and
+// off the starting heading are pulled back by P terms. Finished once the
+// profile has ended and the robot has stayed within tolerance for settle_ms,
+// or at the timeout.
+
+struct DriveGains {
+	ProfileLimits limits; // inches and seconds
+	double kV;            // stick units per in/s
+	double kA;            // stick units per in/s^2
+	double kS;            // stick units to get the chassis moving at all
+	double kP;            // stick units per inch off the profile
+	double kD;            // stick units per in/s off the profile
+	double kP_heading;    // stick units per degree off the starting heading
+};
+
+// 12 V drives the chassis about 15.6 in/s either way (200 rpm, 1000/13 motor degrees per inch)
+const DriveGains DEFAULT_DRIVE_GAINS = {{12, 40, 25, 150}, 8.1, 0.5, 6, 8, 0.5, 2};
+
+class DriveController {
+public:
+	DriveController(double ticks_per_inch, const DriveGains& gains = DEFAULT_DRIVE_GAINS, double tolerance = 0.5,
+	                uint32_t settle_ms = 100, uint32_t timeout_extra_ms = 1000);
+
+	// forward and right in inches, robot frame; fl..br are the motor encoder
+	// positions (degrees) and heading the IMU (degrees) at the start
+	void start(double forward, double right, double fl, double fr, double bl, double br,
+	           double heading, uint32_t now);
+	void update(double fl, double fr, double bl, double br, double heading, uint32_t now);
+
+	// commands for the mixer, stick units
+	double getForward() const;
+	double getRight() const;
+	double getRotation() const;
+
+	bool isSettled() const;
+	bool isTimedOut() const;
+	bool isFinished() const;
+	// inches left along the line
+	double getError() const;
+	double getDuration() const; // s, of the planned profile
+
+private:
+	double ticks_per_inch;
+	DriveGains gains;
+	double tolerance;
+	uint32_t settle_ms;
+	uint32_t timeout_extra_ms;
+
+	MotionProfile profile;
+	double unit_forward = 1; // direction of the line
+	double unit_right = 0;
+	double start_wheels[4] = {0, 0, 0, 0};
+	double start_heading = 0;
+	uint32_t start_time = 0;
+	uint32_t last_time = 0;
+	uint32_t settled_since = 0;
+	double last_progress = 0;
+	double speed = 0; // filtered, in/s along the line
+	double error = 0;
+	double forward_out = 0;
+	double right_out = 0;
+	double rotation_out = 0;
+	bool settled = false;
+	bool timed_out = false;
+};
+
+#endif
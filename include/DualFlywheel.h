@@ -0,0 +1,121 @@
+#ifndef DUAL_FLYWHEEL_H
+#define DUAL_FLYWHEEL_H
+
+// Flywheel speed control for the two shooter motors together.
+// Instead of two independent velocity loops, one loop holds the average speed
+// of the pair on target and a second drives the difference between them to
+// zero, so both motors put the same energy into the disc. Each motor gets its
+// own static friction feedforward; the difference integrator takes up
+// whatever mismatch is left. Speeds are motor rpm, outputs are millivolts for
+// move_voltage(), both positive in the shooting direction.
+
+struct FlywheelGains {
+	double kV;      // mV per rpm
+	double kS1;     // mV, friction of motor 1
+	double kS2;     // mV, friction of motor 2
+	double kP;      // average loop, mV per rpm
+	double kI;      // mV per rpm second
+	double kP_diff; // difference loop
+	double kI_diff;
+};
+
+extern const FlywheelGains DEFAULT_FLYWHEEL_GAINS;
+
+class DualFlywheel {
+public:
+	DualFlywheel(const FlywheelGains& gains, double max_mv = 12000);
+
+	// 0 stops both motors and clears the integrators
+	void setTarget(double rpm);
+	double getTarget() const;
+	// measured speeds, dt in seconds
+	void update(double rpm1, double rpm2, double dt);
+
+	double getVoltage1() const;
+	double getVoltage2() const;
+	double getAverage() const;
+	double getDifference() const; // motor 1 minus motor 2
+
+	// multiplies the feedforward, for battery compensation
+	void setFeedforwardScale(double scale);
+
+	void setGains(const FlywheelGains& gains);
+	const FlywheelGains& getGains() const;
+	void reset();
+
+private:
+	FlywheelGains gains;
+	double max_mv;
+	double feedforward_scale = 1;
+	double target = 0;
+	double average_integral = 0;
+	double difference_integral = 0;
+	double average = 0;
+	double difference = 0;
+	double voltage1 = 0;
+	double voltage2 = 0;
+};
+
+// Flywheel model identified from logged runs (host/flywheel_fit), one per
+// motor: voltage = kS sign(speed) + kV speed + kA acceleration, in mV, rpm
+// and rpm per second
+struct FlywheelModel {
+	double kS[2];
+	double kV[2];
+	double kA[2];
+	double shot_energy; // fraction of the kinetic energy a disc takes
+};
+
+// Two-motor flywheel plant for testing the controller on a computer, in the
+// spirit of okapi::FlywheelSimulator but with one DC motor model per side.
+// Each side has its own inertia and friction; a torsional spring (the belt or
+// shared shaft) couples them, 0 stiffness leaves them independent.
+class DualFlywheelSimulator {
+public:
+	// inertia per side in kg m^2 at the motor output, timestep in seconds
+	DualFlywheelSimulator(double inertia = 0.05, double coupling = 0, double timestep = 0.001);
+
+	// motor voltages in mV, held until changed
+	void setVoltage(double mv1, double mv2);
+	// advances one timestep
+	void step();
+
+	// N m, per motor: friction that holds until the motor moves, and while it moves
+	void setStaticFriction(double friction1, double friction2);
+	void setDynamicFriction(double friction1, double friction2);
+	// scales each motor's torque, 1 is a healthy motor
+	void setStrength(double strength1, double strength2);
+	void setCoupling(double stiffness);
+	// battery voltage in mV; commands are fractions of what a 12.6 V battery gives
+	void setBattery(double battery_mv);
+	void setTimestep(double timestep);
+	// runs from an identified model instead of the physical constants above;
+	// friction, strength and coupling no longer apply
+	void setModel(const FlywheelModel& model);
+	// a disc takes this fraction of the kinetic energy off both sides
+	void shoot(double energy_fraction);
+	// starts from these speeds, e.g. to replay part of a log
+	void setRpm(double rpm1, double rpm2);
+
+	double getRpm1() const;
+	double getRpm2() const;
+	double getTimestep() const;
+
+private:
+	double sideTorque(int side, double coupling_torque) const;
+
+	double inertia;
+	double coupling;
+	double timestep;
+	double voltage[2] = {0, 0};
+	double omega[2] = {0, 0}; // rad/s
+	double twist = 0;         // rad, side 1 ahead of side 2
+	double static_friction[2] = {0.05, 0.05};
+	double dynamic_friction[2] = {0.03, 0.03};
+	double strength[2] = {1, 1};
+	double battery = 12600;
+	bool fitted = false;
+	FlywheelModel model;
+};
+
+#endif
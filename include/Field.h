@@ -0,0 +1,48 @@
+#ifndef FIELD_H
+#define FIELD_H
+
+// Spin Up field geometry in the odometry frame: inches from the center of the
+// field, x to the right and y away from the red driver station, heading in
+// degrees clockwise from +y. Positions are taken from the field drawings and
+// are good to about an inch.
+
+const double FIELD_HALF_SIZE = 70.2; // inside of the perimeter walls
+
+const double RED_GOAL_X = -52.4;
+const double RED_GOAL_Y = 52.4;
+const double BLUE_GOAL_X = 52.4;
+const double BLUE_GOAL_Y = -52.4;
+
+// rollers sit on the walls one tile from the red-left and blue-right corners;
+// heading is the way a robot faces to push its intake against the roller
+struct RollerPosition {
+	double x;
+	double y;
+	double heading;
+};
+
+const int NUM_ROLLERS = 4;
+extern const RollerPosition ROLLERS[NUM_ROLLERS];
+
+// perimeter walls by the way a robot faces to drive straight into them
+// (heading 0, 90, 180, 270)
+enum Wall {
+	WALL_FAR,   // y = +FIELD_HALF_SIZE, away from the red driver station
+	WALL_RIGHT, // x = +FIELD_HALF_SIZE
+	WALL_NEAR,  // y = -FIELD_HALF_SIZE
+	WALL_LEFT   // x = -FIELD_HALF_SIZE
+};
+
+// the wall closest to straight ahead of a heading
+Wall wallAhead(double heading);
+double wallHeading(Wall wall);
+
+enum Alliance {
+	ALLIANCE_RED,
+	ALLIANCE_BLUE
+};
+
+// the goal an alliance scores in
+void goalPosition(Alliance alliance, double& x, double& y);
+
+#endif
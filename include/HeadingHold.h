@@ -0,0 +1,57 @@
+#ifndef HEADING_HOLD_H
+#define HEADING_HOLD_H
+
+#include <cstdint>
+
+// Heading-hold assist for the field-centric x-drive.
+// While the raw rotation stick is inside the deadband the current heading is
+// latched and a PD loop on the IMU heading produces the rotation command, so
+// translating (even at full stick) does not let the robot yaw. The latch is
+// judged on the raw stick, in the same units as the driver profile's deadband:
+// a shaped value near the centre is small by design and would otherwise count
+// as no input. The latch deadband is never below MIN_LATCH_DEADBAND, so a
+// profile with no shaping deadband (Raw) still holds against stick drift.
+// When the driver turns, the shaped rotation passes straight through; once
+// released the new heading is re-latched as soon as the robot stops spinning
+// (or after relatch_ms).
+
+// smallest raw stick deflection that counts as the driver turning
+const double MIN_LATCH_DEADBAND = 5;
+
+class HeadingHold {
+public:
+	HeadingHold(double deadband = 8, double kP = 2.5, double kD = 0.15,
+	            double max_output = 60, uint32_t relatch_ms = 150, double settled_rate = 20);
+
+	// stick: raw rotation stick (-127..127), r: the shaped rotation command,
+	// heading: degrees, now: ms
+	// returns the rotation command to feed into the mixer
+	double update(double stick, double r, double heading, uint32_t now);
+
+	// drop the latched heading, e.g. after the IMU has been reset
+	void reset();
+
+	bool isHolding() const;
+	double getTarget() const;
+
+private:
+	double deadband;
+	double kP;
+	double kD;
+	double max_output;
+	uint32_t relatch_ms;
+	double settled_rate; // deg/s below which the robot counts as stopped
+
+	bool holding = false;
+	bool has_last = false;
+	double target = 0;
+	double last_heading = 0;
+	uint32_t last_time = 0;
+	uint32_t release_time = 0;
+	double rate = 0; // filtered yaw rate, deg/s
+};
+
+// wraps an angle in degrees into [-180, 180)
+double wrapDegrees(double angle);
+
+#endif
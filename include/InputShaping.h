@@ -0,0 +1,75 @@
+#ifndef INPUT_SHAPING_H
+#define INPUT_SHAPING_H
+
+// Drive-input shaping between the controller sticks and the x-drive mixer.
+// Each axis goes through deadband -> response curve -> slew limiter.
+// Nothing in here touches PROS, so recorded stick traces can be replayed
+// through it on a computer (see host/shape_trace.cpp).
+
+enum CurveType {
+	CURVE_LINEAR,
+	CURVE_CUBIC,       // out = (1 - expo) * in + expo * in^3
+	CURVE_EXPONENTIAL  // out = sign(in) * (e^(expo * |in|) - 1) / (e^expo - 1)
+};
+
+struct AxisShape {
+	double deadband;    // stick units (0..127) treated as zero
+	CurveType curve;
+	double expo;        // curve strength, 0 = linear
+	double accel_slew;  // max increase in |output| per second, 0 = unlimited
+	double decel_slew;  // max decrease in |output| per second, 0 = unlimited
+};
+
+struct DriverProfile {
+	const char* name;
+	AxisShape x; // strafe
+	AxisShape y; // forward
+	AxisShape r; // rotation
+};
+
+extern const DriverProfile DRIVER_PROFILES[];
+extern const int NUM_DRIVER_PROFILES;
+
+class AxisShaper {
+public:
+	AxisShaper(const AxisShape& shape);
+
+	// in: raw stick value (-127..127), dt: seconds since the last call,
+	// traction: 1 while the wheels grip, lower scales the accel slew down
+	double update(double in, double dt, double traction = 1);
+	void setShape(const AxisShape& shape);
+	void reset();
+
+private:
+	AxisShape shape;
+	double output = 0;
+};
+
+// applies a deadband, rescaling the remaining travel back to the full range
+double applyDeadband(double in, double deadband);
+// applies the response curve to a value in -127..127
+double applyCurve(double in, CurveType curve, double expo);
+
+class InputShaper {
+public:
+	InputShaper(const DriverProfile& profile);
+
+	// traction (see TractionMonitor) limits how fast translation builds up
+	void update(double raw_x, double raw_y, double raw_r, double dt, double traction = 1);
+	void setProfile(const DriverProfile& profile);
+	void reset();
+
+	double getX() const;
+	double getY() const;
+	double getR() const;
+
+private:
+	AxisShaper x_shaper;
+	AxisShaper y_shaper;
+	AxisShaper r_shaper;
+	double x = 0;
+	double y = 0;
+	double r = 0;
+};
+
+#endif
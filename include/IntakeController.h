@@ -0,0 +1,51 @@
+#ifndef INTAKE_CONTROLLER_H
+#define INTAKE_CONTROLLER_H
+
+#include <cstdint>
+
+// Jam detection for the intake.
+// A motor counts as stalled when it is asked to turn, barely moves and draws
+// a lot of current. A stall that lasts JAM_MS is a jam: the intake reverses
+// briefly and then tries again. After too many retries in a row it gives up
+// and stays stopped until the driver lets go of the button.
+
+enum IntakeState {
+	INTAKE_RUNNING,
+	INTAKE_UNJAMMING,
+	INTAKE_STALLED_OUT
+};
+
+const int INTAKE_MOTORS = 3;
+
+class IntakeController {
+public:
+	IntakeController(uint32_t jam_ms = 150, uint32_t unjam_ms = 250, int max_retries = 3);
+
+	// command: requested speed as a fraction of full (-1..1)
+	// speed: each motor's measured speed as a fraction of full, positive in the intake direction
+	// current: each motor's current draw, mA
+	// returns the speed fraction to apply
+	double update(double command, const double speed[INTAKE_MOTORS], const int current[INTAKE_MOTORS], uint32_t now);
+
+	IntakeState getState() const;
+	uint32_t getJams() const;
+	uint32_t getStallOuts() const;
+
+private:
+	uint32_t jam_ms;
+	uint32_t unjam_ms;
+	int max_retries;
+
+	IntakeState state = INTAKE_RUNNING;
+	double last_command = 0;
+	uint32_t run_start = 0;
+	bool stalled = false;
+	uint32_t stall_start = 0;
+	uint32_t clear_since = 0;
+	uint32_t unjam_start = 0;
+	int retries = 0;
+	uint32_t jams = 0;
+	uint32_t stall_outs = 0;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef LOCALIZATION_H
+#define LOCALIZATION_H
+
+#include "Odometry.h"
+#include <cstdint>
+#include <random>
+
+// Global pose from wheel odometry, the IMU and GPS fixes.
+// Odometry displacements and the IMU heading are integrated every tick
+// (prediction), and each GPS fix pulls the position toward it by a Kalman
+// gain from the uncertainty built up since the last fix and the sensor's
+// own reported error. Fixes that are stale, too noisy, or inconsistent with
+// the current estimate are rejected. If consistent fixes keep disagreeing
+// (the robot got shoved), the estimate is reopened so it can re-converge
+// instead of staying wrong for the rest of the run.
+
+struct GpsFix {
+	bool valid;
+	double x;       // inches, field frame
+	double y;
+	double heading; // degrees
+	double error;   // inches, as reported by the sensor
+};
+
+class Localization {
+public:
+	Localization();
+
+	// robot-frame displacement since the last call (inches) and the IMU heading;
+	// traction below 1 (see TractionMonitor) grows the uncertainty faster
+	void predict(double forward, double right, double imu_heading, double traction = 1);
+	// returns true if the fix was used
+	bool correct(const GpsFix& fix);
+
+	void reset(const Pose& pose);
+	Pose getPose() const;
+	double getStdDev() const; // position uncertainty, inches
+
+	uint32_t getAccepted() const;
+	uint32_t getRejected() const;
+
+private:
+	Pose pose = {0, 0, 0};
+	double heading_offset = 0; // field heading - IMU heading
+	bool has_imu = false;
+	double last_imu = 0;
+	double variance = 1;       // in^2, same on both axes
+
+	double last_fix_x = 0;
+	double last_fix_y = 0;
+	int repeated_fixes = 0;
+	int disagreeing_fixes = 0;
+	uint32_t accepted = 0;
+	uint32_t rejected = 0;
+};
+
+// GPS stand-in for testing the fusion on a computer: noisy fixes around the
+// true pose, with occasional dropouts and wild outliers
+class SimulatedGps {
+public:
+	SimulatedGps(double noise = 0.8, double dropout = 0.05, double outlier = 0.02, unsigned seed = 1);
+	GpsFix read(const Pose& truth);
+
+private:
+	double noise;
+	double dropout;
+	double outlier;
+	std::mt19937 rng;
+};
+
+#endif
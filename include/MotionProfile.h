@@ -0,0 +1,54 @@
+#ifndef MOTION_PROFILE_H
+#define MOTION_PROFILE_H
+
+// Time-optimal 1D motion profiles for autonomous moves.
+// The profile speeds up, cruises and slows down, each ramp limited by its own
+// acceleration and, when max_jerk is set, jerk (an S-curve: the acceleration
+// itself ramps so the wheels are not shocked into slipping). Moves too short
+// to reach max_velocity peak lower. The peak speed is found once when the
+// profile is planned; after that any time is sampled in closed form, so
+// following it costs a few multiplies per tick.
+// Distances may be negative; the limits are magnitudes. Units are whatever
+// the caller uses (degrees for turns, inches for drives) with time in seconds.
+
+struct ProfileLimits {
+	double max_velocity;
+	double max_accel;
+	double max_decel;
+	double max_jerk; // 0 for no limit, a plain trapezoid
+};
+
+struct ProfileState {
+	double position;
+	double velocity;
+	double acceleration;
+};
+
+class MotionProfile {
+public:
+	MotionProfile(double distance = 0, const ProfileLimits& limits = {1, 1, 1, 0});
+
+	ProfileState sample(double t) const;
+	double getDuration() const;
+	double getDistance() const;
+	double getPeakVelocity() const;
+
+private:
+	// one speed-up (or, run backwards, slow-down) ramp from rest to peak
+	struct Ramp {
+		double accel;     // peak acceleration reached
+		double jerk_time; // time spent ramping the acceleration, each end
+		double duration;
+	};
+	static Ramp planRamp(double velocity, double max_accel, double max_jerk);
+	ProfileState sampleRamp(const Ramp& ramp, double t) const;
+
+	double distance;
+	double sign;
+	double peak_velocity;
+	Ramp up;
+	Ramp down;
+	double cruise_time;
+};
+
+#endif
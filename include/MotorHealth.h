@@ -0,0 +1,62 @@
+#ifndef MOTOR_HEALTH_H
+#define MOTOR_HEALTH_H
+
+#include "api.h"
+#include "Subsystem.h"
+#include <string>
+#include <vector>
+
+// Low-rate motor health monitor.
+// Polls temperature and the over-temp/over-current flags of every registered
+// motor, fits the temperature trend over the last minute and predicts how long
+// until the motor reaches the firmware derate point (where it silently halves
+// its output). Subsystems running hot get a command scale below 1 so the
+// control code can ease off before the derate happens instead of after.
+
+const double MOTOR_WARN_TEMP = 45;   // degC
+const double MOTOR_DERATE_TEMP = 55; // degC, V5 motors start limiting here
+
+class MotorHealth {
+public:
+	MotorHealth(uint32_t period_ms = 1000);
+
+	void addMotor(pros::Motor* motor, Subsystem subsystem, const char* name);
+
+	// polls every motor once
+	void update();
+	// runs update() in a low-priority background task
+	void start();
+
+	// 1 when healthy, lower when the subsystem should be eased off
+	double getScale(Subsystem subsystem) const;
+	// worst warning, empty when everything is fine
+	std::string getWarning() const;
+
+private:
+	static const int HISTORY = 60;
+
+	struct Entry {
+		pros::Motor* motor;
+		Subsystem subsystem;
+		const char* name;
+		double temps[HISTORY];
+		uint32_t times[HISTORY];
+		int count;
+		int next;
+		double temperature;
+		double slope;          // degC/s
+		double time_to_derate; // s, negative when not heating
+		bool over_temp;
+		bool over_current;
+		int level;             // 0 ok, 1 warm, 2 derate soon, 3 derating
+	};
+
+	uint32_t period_ms;
+	std::vector<Entry> motors;
+	double scale[NUM_SUBSYSTEMS];
+	std::string warning;
+	mutable pros::Mutex warning_mutex;
+	pros::Task* task = nullptr;
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef ODOMETRY_H
+#define ODOMETRY_H
+
+// Wheel odometry for the x-drive.
+// Turns the motor encoders into the robot-frame displacement of each step;
+// Localization integrates it with the IMU heading into the field pose, so
+// there is one pose and one heading baseline to reset.
+// Field frame: x to the right and y forward as seen from the starting tile,
+// heading in degrees clockwise like the IMU. Distances are in inches, the
+// same unit moveForward() takes.
+
+struct Pose {
+	double x;
+	double y;
+	double heading;
+};
+
+class Odometry {
+public:
+	Odometry(double ticks_per_inch);
+
+	// fl..br: motor encoder positions (degrees)
+	void update(double fl, double fr, double bl, double br);
+
+	// last robot-frame displacement, inches (forward, right)
+	double getLastForward() const;
+	double getLastRight() const;
+
+private:
+	double ticks_per_inch;
+	bool initialized = false;
+	double last_fl = 0;
+	double last_fr = 0;
+	double last_bl = 0;
+	double last_br = 0;
+	double last_forward = 0;
+	double last_right = 0;
+};
+
+#endif
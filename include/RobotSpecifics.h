@@ -10,4 +10,23 @@
  #define GREEN
  //#define GOLD
 
+// Driver assists
+// Holds the latched IMU heading whenever the rotation stick is released
+ #define HEADING_HOLD
+// R1 sets the flywheel from the distance to the goal instead of a fixed 166
+ #define AUTO_FLYWHEEL
+
+// Sensors
+// Fuse the GPS sensor into the pose estimate. Off until GPS_OFFSET_X/Y and
+// the GPS frame against Field.h have been measured on the robot
+ //#define USE_GPS
+
+// Control
+// Runs both flywheel motors from one loop that also keeps their speeds equal
+ #define SYNC_FLYWHEEL
+
+// Logging
+// Write flywheel samples to /usd/flywheel.csv for host/flywheel_fit
+ //#define LOG_FLYWHEEL
+
 #endif
@@ -0,0 +1,58 @@
+#ifndef ROLLER_CONTROLLER_H
+#define ROLLER_CONTROLLER_H
+
+#include "Field.h"
+#include <cstdint>
+
+// Spins the roller until the optical sensor sees the wanted color instead of
+// for a fixed time. Once the color shows up the roller stops and the color
+// has to hold for settle_ms; if it slid past, the roller creeps back on at a
+// lower speed. Gives up after timeout_ms.
+
+enum RollerColor {
+	ROLLER_UNKNOWN,
+	ROLLER_RED,
+	ROLLER_BLUE
+};
+
+enum RollerState {
+	ROLLER_IDLE,
+	ROLLER_SPINNING,
+	ROLLER_SETTLING,
+	ROLLER_DONE,
+	ROLLER_TIMED_OUT
+};
+
+// proximity is the sensor's 0..255 reading, the roller has to be close
+RollerColor classifyRoller(double hue, double saturation, int proximity);
+RollerColor allianceRollerColor(Alliance alliance);
+
+class RollerController {
+public:
+	RollerController(uint32_t timeout_ms = 1500, uint32_t settle_ms = 30, double creep_speed = 0.35);
+
+	void start(RollerColor target, uint32_t now);
+	// feed one sensor reading, returns true once finished (done or timed out)
+	bool update(double hue, double saturation, int proximity, uint32_t now);
+
+	// fraction of full roller speed to command right now
+	double getSpeed() const;
+	RollerState getState() const;
+	uint32_t getDuration() const;   // ms from start to finish
+	uint32_t getFirstSeen() const;  // ms from start until the color was first seen
+
+private:
+	uint32_t timeout_ms;
+	uint32_t settle_ms;
+	double creep_speed;
+
+	RollerColor target = ROLLER_UNKNOWN;
+	RollerState state = ROLLER_IDLE;
+	bool creeping = false;
+	uint32_t start_time = 0;
+	uint32_t settle_start = 0;
+	uint32_t first_seen = 0;
+	uint32_t duration = 0;
+};
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef ROUTINE_H
+#define ROUTINE_H
+
+#include "Command.h"
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Autonomous routines are declared as data: a tree of steps naming actions
+// and conditions. compileRoutine() turns the tree into a command graph using
+// an action table, so the same routine runs on the robot (actions drive the
+// motors) or on a computer (actions drive a simulation).
+
+enum StepType {
+	STEP_SEQUENCE,
+	STEP_PARALLEL,
+	STEP_RACE,
+	STEP_DEADLINE,
+	STEP_ACTION,
+	STEP_WAIT,
+	STEP_WAIT_UNTIL,
+	STEP_GUARD
+};
+
+struct Step {
+	StepType type;
+	std::string name; // action or condition
+	double arg;       // action argument, wait time or wait-until timeout (ms)
+	std::vector<Step> children;
+};
+
+Step seq(std::vector<Step> steps);
+Step par(std::vector<Step> steps);
+Step race(std::vector<Step> steps);
+// the first step is the deadline, the others are cancelled when it finishes
+Step deadline(std::vector<Step> steps);
+Step act(const std::string& action, double arg = 0);
+Step delayMs(double ms);
+Step waitUntil(const std::string& condition, double timeout_ms = 0);
+// runs body, but if condition trips first cancels it and runs recovery instead
+Step unless(const std::string& condition, Step body);
+Step unless(const std::string& condition, Step body, Step recovery);
+
+struct Routine {
+	const char* name;
+	Step root;
+};
+
+extern const std::vector<Routine> AUTON_ROUTINES;
+
+struct ActionTable {
+	std::map<std::string, std::function<CommandPtr(double)>> actions;
+	std::map<std::string, std::function<bool()>> conditions;
+};
+
+// unknown actions or conditions become no-ops and are listed in errors
+CommandPtr compileRoutine(const Step& step, const ActionTable& table, std::vector<std::string>* errors = nullptr);
+
+// runs a compiled routine at a fixed tick and keeps the timing report
+class RoutineRunner {
+public:
+	RoutineRunner(CommandPtr root);
+
+	// call once per tick, returns true when the routine is done
+	bool tick(uint32_t now);
+	void cancel(uint32_t now);
+	std::vector<CommandTiming> getTimings() const;
+
+private:
+	CommandPtr root;
+	bool started = false;
+	bool done = false;
+};
+
+#endif
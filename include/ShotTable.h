@@ -0,0 +1,50 @@
+#ifndef SHOT_TABLE_H
+#define SHOT_TABLE_H
+
+#include <vector>
+
+// Distance-to-goal -> flywheel velocity calibration.
+// Points are interpolated linearly (clamped at the ends), or, once there are
+// enough of them, a quadratic can be fitted through them instead. Shot
+// outcomes marked during practice nudge the table, and the table is kept on
+// the SD card as "distance,rpm" lines so calibration survives a re-upload.
+
+struct ShotPoint {
+	double distance; // inches to the goal
+	double rpm;      // flywheel target (motor velocity units)
+};
+
+enum ShotOutcome {
+	SHOT_HIT,
+	SHOT_SHORT,
+	SHOT_LONG
+};
+
+class ShotTable {
+public:
+	ShotTable(std::vector<ShotPoint> points);
+
+	double getRpm(double distance) const;
+
+	// use a least-squares quadratic instead of interpolating
+	void setFitted(bool fitted);
+	bool isFitted() const;
+
+	// folds in a shot taken at distance with the given rpm
+	void recordOutcome(double distance, double rpm, ShotOutcome outcome);
+
+	bool loadCsv(const char* path);
+	bool saveCsv(const char* path) const;
+	const std::vector<ShotPoint>& getPoints() const;
+
+private:
+	void sortAndFit();
+
+	std::vector<ShotPoint> points;
+	bool fitted = false;
+	double a = 0; // rpm = a + b * d + c * d^2
+	double b = 0;
+	double c = 0;
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include "api.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Brings the robot up at power-on.
+// Each step runs in its own task as soon as the steps it comes after have
+// finished, so the IMU's two second calibration overlaps the SD card, the LCD
+// and the self-checks instead of holding them up. A step that fails still
+// counts as finished for the ones after it; they decide for themselves what
+// to do without it. Once everything has finished the time each step took is
+// logged, so a slow device shows up in the first capture of the day.
+
+struct StartupTiming {
+	std::string name;
+	bool done;
+	bool ok;
+	uint32_t start; // ms after Startup::start()
+	uint32_t end;
+};
+
+class Startup {
+public:
+	// run returns false if the step failed; after names steps added earlier.
+	// Steps can only be added before start()
+	void add(const std::string& name, std::function<bool()> run, std::vector<std::string> after = {});
+	// launches every step, returns straight away
+	void start();
+
+	bool isDone(const std::string& name) const;
+	bool isFinished() const;
+	// blocks until the step has finished or timeout_ms has passed, returns
+	// false if it has not finished or failed
+	bool waitFor(const std::string& name, uint32_t timeout_ms) const;
+	std::vector<StartupTiming> getTimings() const;
+
+private:
+	struct Step {
+		std::string name;
+		std::function<bool()> run;
+		std::vector<size_t> after;
+		bool done = false;
+		bool ok = false;
+		uint32_t start = 0;
+		uint32_t end = 0;
+	};
+
+	void runStep(size_t index);
+	int find(const std::string& name) const;
+	void report() const;
+
+	std::vector<Step> steps;
+	std::vector<pros::Task*> tasks;
+	mutable pros::Mutex mutex;
+	uint32_t begin = 0;
+	bool started = false;
+	bool reported = false;
+};
+
+#endif
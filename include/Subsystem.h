@@ -0,0 +1,14 @@
+#ifndef SUBSYSTEM_H
+#define SUBSYSTEM_H
+
+// Groups of motors that are managed together (current budget, health, ...)
+enum Subsystem {
+	SUBSYSTEM_DRIVE,
+	SUBSYSTEM_FLYWHEEL,
+	SUBSYSTEM_INTAKE,
+	NUM_SUBSYSTEMS
+};
+
+const char* subsystemName(Subsystem subsystem);
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+// Telemetry goes out over the USB serial terminal (stdout) as one line per
+// record: "<tag> <time ms> <fields...>", so a capture from `pros terminal`
+// can be split by tag and loaded straight into a spreadsheet.
+
+void telemetry_log(const char* tag, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+#endif
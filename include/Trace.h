@@ -0,0 +1,68 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Binary driver trace: a small header followed by fixed-size frames, written
+// to the SD card by the opcontrol() recorder and replayed in autonomous().
+// Plain stdio so traces can be read on a computer too.
+
+#define TRACE_VERSION 2
+
+enum TraceButton : uint16_t {
+	BTN_R1 = 1 << 0,
+	BTN_R2 = 1 << 1,
+	BTN_L1 = 1 << 2,
+	BTN_L2 = 1 << 3,
+	BTN_UP = 1 << 4,
+	BTN_DOWN = 1 << 5,
+	BTN_LEFT = 1 << 6,
+	BTN_RIGHT = 1 << 7,
+	BTN_X = 1 << 8,
+	BTN_Y = 1 << 9,
+	BTN_A = 1 << 10,
+	BTN_B = 1 << 11
+};
+
+struct TraceHeader {
+	char magic[4]; // "GSTR"
+	uint16_t version;
+	uint16_t tick_ms;
+	uint16_t profile; // driver input profile used while recording
+	uint16_t alliance; // Alliance (Field.h) recorded on; version 1 traces have none and load as red
+};
+
+struct TraceFrame {
+	uint32_t time;   // ms since the recording started
+	int8_t left_x;
+	int8_t left_y;
+	int8_t right_x;
+	int8_t right_y;
+	uint16_t held;    // TraceButton bits
+	uint16_t pressed; // buttons newly pressed since the previous frame
+	float x;          // pose when recorded, inches and degrees
+	float y;
+	float heading;
+};
+
+class TraceWriter {
+public:
+	~TraceWriter();
+
+	bool open(const char* path, uint16_t tick_ms, uint16_t profile, uint16_t alliance);
+	bool write(const TraceFrame& frame);
+	void close();
+	bool isOpen() const;
+	uint32_t getFrameCount() const;
+
+private:
+	FILE* file = nullptr;
+	uint32_t frames = 0;
+};
+
+// loads a whole trace, returns false if the file is missing or malformed
+bool loadTrace(const char* path, TraceHeader& header, std::vector<TraceFrame>& frames);
+
+#endif
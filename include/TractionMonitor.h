@@ -0,0 +1,67 @@
+#ifndef TRACTION_MONITOR_H
+#define TRACTION_MONITOR_H
+
+// Wheel-slip detection for the x-drive, per robot axis.
+// The encoders say how fast the wheels are turning, the IMU accelerometer how
+// the chassis is really speeding up. Each axis keeps an estimate of the true
+// speed: the IMU acceleration integrated every tick and pulled toward the
+// encoder speed while the two agree. When the wheels break loose the encoder
+// acceleration runs away from the IMU's, the pull is dropped, and the gap
+// between the encoder speed and the estimate is the slip. A wheel spinning
+// against a wall or another robot keeps showing as slip for about a second
+// after the accelerations have settled; a longer push looks like cruising to
+// an accelerometer, so the estimate then drifts back to the encoders rather
+// than integrating the accelerometer bias forever.
+// The bias is learned while the robot sits still.
+
+enum TractionAxis {
+	AXIS_FORWARD,
+	AXIS_RIGHT
+};
+
+class TractionMonitor {
+public:
+	// accel_threshold: in/s^2 of disagreement that counts as breaking loose
+	// slip_deadband, full_slip: in/s of slip where traction starts to fall and reaches 0
+	TractionMonitor(double accel_threshold = 60, double slip_deadband = 2, double full_slip = 10,
+	                double tracking_gain = 0.1);
+
+	// forward, right: encoder displacement this tick (inches, robot frame),
+	// accel_forward, accel_right: IMU acceleration (g, robot frame), dt: seconds
+	void update(double forward, double right, double accel_forward, double accel_right, double dt);
+	void reset();
+
+	// 1 while the wheels grip, falling to 0 as they spin freely
+	double getTraction(TractionAxis axis) const;
+	double getTraction() const; // the worse of the two axes
+	bool isSlipping(TractionAxis axis) const;
+	double getSlip(TractionAxis axis) const;  // in/s, encoder minus estimated speed
+	double getSpeed(TractionAxis axis) const; // in/s, estimated true speed
+
+	// displacement to trust this tick: the encoders while they grip, the
+	// estimated speed as they slip
+	double getForward() const;
+	double getRight() const;
+
+private:
+	struct Axis {
+		double encoder_speed = 0; // in/s
+		double encoder_accel = 0; // in/s^2, filtered
+		double imu_accel = 0;     // in/s^2, filtered, bias removed
+		double bias = 0;          // in/s^2
+		double speed = 0;         // estimate, in/s
+		bool breaking_loose = false;
+		double displacement = 0;  // trusted, inches
+	};
+	void updateAxis(Axis& axis, double displacement, double accel_g, double dt);
+	double traction(const Axis& axis) const;
+
+	double accel_threshold;
+	double slip_deadband;
+	double full_slip;
+	double tracking_gain;
+	bool initialized = false;
+	Axis axes[2];
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef TURN_CONTROLLER_H
+#define TURN_CONTROLLER_H
+
+#include "MotionProfile.h"
+#include <cstdint>
+
+// Turns in place on the IMU heading.
+// A trapezoidal profile plans the fastest turn the limits allow, velocity and
+// acceleration feedforward drive along it, and a PD loop on the IMU heading
+// against the profile corrects for slip and battery. The turn is finished
+// once the profile has ended and the heading has stayed within tolerance for
+// settle_ms (which it cannot do while still swinging through), or at the
+// timeout.
+
+struct TurnGains {
+	double max_velocity; // deg/s
+	double max_accel;    // deg/s^2
+	double kV;           // stick units per deg/s
+	double kA;           // stick units per deg/s^2
+	double kS;           // stick units to get the chassis turning at all
+	double kP;           // stick units per degree behind the profile
+	double kD;           // stick units per deg/s behind the profile
+};
+
+// 12 V turns the chassis about 97 deg/s (200 rpm, 1000/81 motor degrees per degree)
+const TurnGains DEFAULT_TURN_GAINS = {80, 300, 1.3, 0.1, 6, 4, 0.3};
+
+class TurnController {
+public:
+	TurnController(const TurnGains& gains = DEFAULT_TURN_GAINS, double tolerance = 1,
+	               uint32_t settle_ms = 100, uint32_t timeout_extra_ms = 1000);
+
+	// angle in degrees, positive clockwise, from the current heading
+	void start(double angle, double heading, uint32_t now);
+	// heading from the IMU in degrees (any wrap), returns the rotation command
+	// for the mixer in stick units
+	double update(double heading, uint32_t now);
+
+	bool isSettled() const;
+	bool isTimedOut() const;
+	bool isFinished() const;
+	// degrees left to turn, positive clockwise
+	double getError() const;
+	double getDuration() const; // s, of the planned profile
+
+private:
+	TurnGains gains;
+	double tolerance;
+	uint32_t settle_ms;
+	uint32_t timeout_extra_ms;
+
+	MotionProfile profile;
+	uint32_t start_time = 0;
+	uint32_t last_time = 0;
+	uint32_t settled_since = 0;
+	double last_heading = 0;
+	double turned = 0; // unwrapped degrees since start
+	double rate = 0;   // filtered yaw rate, deg/s
+	double error = 0;
+	bool settled = false;
+	bool timed_out = false;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef WALL_SQUARE_H
+#define WALL_SQUARE_H
+
+#include "Field.h"
+#include "Odometry.h"
+#include <cstdint>
+
+// Re-localizes against a perimeter wall.
+// The robot pushes one face gently into the wall ahead of it and lets the
+// wall square it up. It counts as flush once it has touched the wall (see
+// CollisionDetector), the wheels on either half of the pushing face draw
+// about the same current (one corner hanging off the wall would show as an
+// imbalance) and the heading has stayed within settled_band of where it was
+// for flush_ms. The heading
+// is then exactly the wall's and the distance to the wall exactly half the
+// robot's length, so those two parts of the pose can be reset; the position
+// along the wall cannot be known and is kept.
+
+enum RobotFace {
+	FACE_FRONT,
+	FACE_RIGHT,
+	FACE_BACK,
+	FACE_LEFT
+};
+
+class WallSquare {
+public:
+	// half_length: robot center to the bumper of the pushing face, inches;
+	// push: stick units; min_current: mA each wheel draws while pushing;
+	// balance: allowed current difference as a fraction of the total;
+	// settled_band: degrees the heading may wander while flush
+	WallSquare(double half_length, double push = 60, double min_current = 150, double balance = 0.3,
+	           double settled_band = 1, uint32_t flush_ms = 150);
+
+	// picks the wall the face is pointing at from the current estimate;
+	// timeout_ms 0 gives up after the default 2 s
+	void start(RobotFace face, const Pose& estimate, uint32_t now, uint32_t timeout_ms = 0);
+	// current: drive motor draw (mA), fl..br; heading: IMU degrees;
+	// touching: the collision detector is reporting contact
+	// returns true once flush or timed out
+	bool update(const double current[4], double heading, bool touching, uint32_t now);
+
+	// push for the mixer, stick units
+	double getForward() const;
+	double getRight() const;
+
+	bool isFlush() const;
+	bool isTimedOut() const;
+	Wall getWall() const;
+	// estimate with the heading and the distance to the wall replaced
+	Pose correct(const Pose& estimate) const;
+
+private:
+	double half_length;
+	double push;
+	double min_current;
+	double balance;
+	double settled_band;
+	uint32_t flush_ms;
+	uint32_t timeout_ms = 0;
+
+	RobotFace face = FACE_FRONT;
+	Wall wall = WALL_FAR;
+	uint32_t start_time = 0;
+	uint32_t flush_since = 0;
+	double flush_heading = 0; // heading when the flush window opened
+	bool touched = false;
+	bool flush = false;
+	bool timed_out = false;
+};
+
+#endif
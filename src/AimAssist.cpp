@@ -0,0 +1,57 @@
+#include "AimAssist.h"
+#include "HeadingHold.h"
+#include <cmath>
+
+double bearingTo(double from_x, double from_y, double to_x, double to_y) {
+	return std::atan2(to_x - from_x, to_y - from_y) * 180 / M_PI;
+}
+
+AimAssist::AimAssist(double tolerance, double kP, double kD, double max_output,
+                     double kS, uint32_t settle_ms, double settle_rate)
+	: tolerance(tolerance), kP(kP), kD(kD), max_output(max_output),
+	  kS(kS), settle_ms(settle_ms), settle_rate(settle_rate) {}
+
+double AimAssist::update(double target, double heading, uint32_t now) {
+	if (has_last && now > last_time) {
+		double dt = (now - last_time) / 1000.0;
+		rate = 0.7 * rate + 0.3 * wrapDegrees(heading - last_heading) / dt;
+	}
+	last_heading = heading;
+	last_time = now;
+	has_last = true;
+
+	error = wrapDegrees(target - heading);
+	bool inside = std::fabs(error) < tolerance && std::fabs(rate) < settle_rate;
+	if (inside && !in_tolerance) {
+		in_tolerance_since = now;
+	}
+	in_tolerance = inside;
+	settled = inside && now - in_tolerance_since >= settle_ms;
+
+	if (std::fabs(error) < tolerance / 2) {
+		return -kD * rate;
+	}
+	double output = kP * error - kD * rate + (error > 0 ? kS : -kS);
+	if (output > max_output) {
+		output = max_output;
+	}
+	else if (output < -max_output) {
+		output = -max_output;
+	}
+	return output;
+}
+
+void AimAssist::reset() {
+	has_last = false;
+	rate = 0;
+	in_tolerance = false;
+	settled = false;
+}
+
+bool AimAssist::isSettled() const {
+	return settled;
+}
+
+double AimAssist::getError() const {
+	return error;
+}
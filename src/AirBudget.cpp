@@ -0,0 +1,49 @@
+#include "AirBudget.h"
+#include <cmath>
+
+AirBudget::AirBudget(const AirTank& tank) : tank(tank) {
+	reset();
+}
+
+void AirBudget::recordActuation(bool extended) {
+	double volume = extended ? tank.extend_ml : tank.retract_ml;
+	// the cylinder already holds atmospheric air, so only the gauge part is shared out
+	pressure *= tank.tank_ml / (tank.tank_ml + volume);
+	actuations++;
+}
+
+void AirBudget::reset() {
+	pressure = tank.start_psi;
+	actuations = 0;
+}
+
+double AirBudget::getPressure() const {
+	return pressure;
+}
+
+uint32_t AirBudget::getActuations() const {
+	return actuations;
+}
+
+int AirBudget::getShotsLeft() const {
+	if (pressure <= tank.min_psi) {
+		return 0;
+	}
+	// one shot is an extend and a retract
+	double ratio = tank.tank_ml / (tank.tank_ml + tank.extend_ml) * tank.tank_ml / (tank.tank_ml + tank.retract_ml);
+	return (int)(std::log(tank.min_psi / pressure) / std::log(ratio));
+}
+
+bool AirBudget::isLow() const {
+	return getPressure() < tank.min_psi;
+}
+
+uint32_t AirBudget::getDwell() const {
+	// the force on the piston goes with gauge pressure
+	double gauge = getPressure();
+	if (gauge <= 0) {
+		return tank.max_dwell_ms;
+	}
+	double dwell = tank.full_dwell_ms * std::sqrt(tank.start_psi / gauge);
+	return dwell > tank.max_dwell_ms ? tank.max_dwell_ms : (uint32_t)dwell;
+}
@@ -0,0 +1,24 @@
+#include "BatteryCompensation.h"
+#include <algorithm>
+
+BatteryCompensation::BatteryCompensation(double reference_mv, double max_scale, double filter)
+	: reference_mv(reference_mv), max_scale(max_scale), filter(filter) {}
+
+void BatteryCompensation::update(double battery_mv) {
+	if (battery_mv <= 0) {
+		return;
+	}
+	voltage = voltage == 0 ? battery_mv : voltage + filter * (battery_mv - voltage);
+}
+
+double BatteryCompensation::getVoltage() const {
+	return voltage;
+}
+
+double BatteryCompensation::getScale() const {
+	if (voltage <= 0) {
+		return 1;
+	}
+	// a charger-fresh battery above the reference is not scaled down
+	return std::clamp(reference_mv / voltage, 1.0, max_scale);
+}
@@ -0,0 +1,87 @@
+#include "CollisionDetector.h"
+#include <cmath>
+
+CollisionDetector::CollisionDetector(double jerk_threshold, double stall_current, double stall_rpm,
+                                     double slip_traction, uint32_t stall_ms, uint32_t hold_ms)
+	: jerk_threshold(jerk_threshold), stall_current(stall_current), stall_rpm(stall_rpm),
+	  slip_traction(slip_traction), stall_ms(stall_ms), hold_ms(hold_ms) {}
+
+ContactType CollisionDetector::update(double accel_forward, double accel_right, const double current[4],
+                                      const double rpm[4], double traction, uint32_t now) {
+	ContactType seen = CONTACT_NONE;
+
+	if (has_last && now > last_time) {
+		double dt = (now - last_time) / 1000.0;
+		double jerk_forward = (accel_forward - last_forward) / dt;
+		double jerk_right = (accel_right - last_right) / dt;
+		// light filter, a real hit lasts a few ticks
+		jerk = 0.5 * jerk + 0.5 * std::hypot(jerk_forward, jerk_right);
+		if (jerk > jerk_threshold) {
+			seen = CONTACT_IMPACT;
+			// the chassis is pushed away from what it hit
+			impact_direction = std::atan2(-jerk_right, -jerk_forward) * 180 / M_PI;
+		}
+	}
+	has_last = true;
+	last_forward = accel_forward;
+	last_right = accel_right;
+	last_time = now;
+
+	// every wheel working hard and none of them getting anywhere, or the
+	// wheels spinning out
+	double total_current = 0, total_rpm = 0;
+	for (int i = 0; i < 4; i++) {
+		total_current += std::fabs(current[i]);
+		total_rpm += std::fabs(rpm[i]);
+	}
+	bool stalled = (total_current / 4 > stall_current && total_rpm / 4 < stall_rpm) || traction < slip_traction;
+	if (!stalled) {
+		stalling = false;
+	}
+	else if (!stalling) {
+		stalling = true;
+		stall_since = now;
+	}
+	if (stalling && now - stall_since >= stall_ms && seen == CONTACT_NONE) {
+		seen = CONTACT_PUSHING;
+	}
+
+	if (seen != CONTACT_NONE) {
+		if (contact == CONTACT_NONE) {
+			contacts++;
+		}
+		contact = seen;
+		contact_time = now;
+	}
+	else if (contact != CONTACT_NONE && now - contact_time > hold_ms) {
+		contact = CONTACT_NONE;
+	}
+	return contact;
+}
+
+void CollisionDetector::reset() {
+	has_last = false;
+	jerk = 0;
+	stalling = false;
+	contact = CONTACT_NONE;
+}
+
+ContactType CollisionDetector::getContact() const {
+	return contact;
+}
+
+bool CollisionDetector::inContact() const {
+	return contact != CONTACT_NONE;
+}
+
+double CollisionDetector::getImpactDirection() const {
+	return impact_direction;
+}
+
+double CollisionDetector::getJerk() const {
+	return jerk;
+}
+
+uint32_t CollisionDetector::getContacts() const {
+	return contacts;
+}
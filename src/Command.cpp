@@ -0,0 +1,252 @@
+#include "Command.h"
+
+Command::Command(const std::string& name) : name(name) {}
+
+void Command::start(uint32_t now) {
+	now_time = now;
+	start_time = now;
+	end_time = now;
+	running = true;
+	ran = true;
+	interrupted = false;
+	initialize();
+}
+
+bool Command::update(uint32_t now) {
+	if (!running) {
+		return true;
+	}
+	now_time = now;
+	execute();
+	if (isFinished()) {
+		end(false);
+		running = false;
+		end_time = now;
+		return true;
+	}
+	return false;
+}
+
+void Command::cancel(uint32_t now) {
+	if (!running) {
+		return;
+	}
+	now_time = now;
+	end(true);
+	running = false;
+	interrupted = true;
+	end_time = now;
+}
+
+bool Command::isRunning() const {
+	return running;
+}
+
+bool Command::hasRun() const {
+	return ran;
+}
+
+const std::string& Command::getName() const {
+	return name;
+}
+
+void Command::collectTimings(std::vector<CommandTiming>& out, int depth) const {
+	out.push_back({name, depth, ran, interrupted, start_time, running ? now_time : end_time});
+}
+
+uint32_t Command::time() const {
+	return now_time;
+}
+
+uint32_t Command::elapsed() const {
+	return now_time - start_time;
+}
+
+FunctionCommand::FunctionCommand(const std::string& name, std::function<void()> on_start,
+                                 std::function<void()> on_execute,
+                                 std::function<bool(uint32_t)> is_finished,
+                                 std::function<void(bool)> on_end)
+	: Command(name), on_start(on_start), on_execute(on_execute),
+	  is_finished(is_finished), on_end(on_end) {}
+
+void FunctionCommand::initialize() {
+	if (on_start) {
+		on_start();
+	}
+}
+
+void FunctionCommand::execute() {
+	if (on_execute) {
+		on_execute();
+	}
+}
+
+bool FunctionCommand::isFinished() {
+	return !is_finished || is_finished(elapsed());
+}
+
+void FunctionCommand::end(bool interrupted) {
+	if (on_end) {
+		on_end(interrupted);
+	}
+}
+
+WaitCommand::WaitCommand(uint32_t ms) : Command("wait " + std::to_string(ms)), ms(ms) {}
+
+bool WaitCommand::isFinished() {
+	return elapsed() >= ms;
+}
+
+WaitUntilCommand::WaitUntilCommand(const std::string& name, std::function<bool()> condition, uint32_t timeout_ms)
+	: Command("until " + name), condition(condition), timeout_ms(timeout_ms) {}
+
+bool WaitUntilCommand::isFinished() {
+	return condition() || (timeout_ms > 0 && elapsed() >= timeout_ms);
+}
+
+CommandGroup::CommandGroup(const std::string& name, std::vector<CommandPtr> commands)
+	: Command(name), commands(std::move(commands)) {}
+
+void CommandGroup::collectTimings(std::vector<CommandTiming>& out, int depth) const {
+	Command::collectTimings(out, depth);
+	for (const CommandPtr& command : commands) {
+		command->collectTimings(out, depth + 1);
+	}
+}
+
+void CommandGroup::end(bool) {
+	for (CommandPtr& command : commands) {
+		command->cancel(time());
+	}
+}
+
+SequentialGroup::SequentialGroup(std::vector<CommandPtr> commands, const std::string& name)
+	: CommandGroup(name, std::move(commands)) {}
+
+void SequentialGroup::initialize() {
+	current = 0;
+	if (!commands.empty()) {
+		commands[0]->start(time());
+	}
+}
+
+void SequentialGroup::execute() {
+	// instant commands chain through within one tick
+	while (current < commands.size() && commands[current]->update(time())) {
+		current++;
+		if (current < commands.size()) {
+			commands[current]->start(time());
+		}
+	}
+}
+
+bool SequentialGroup::isFinished() {
+	return current >= commands.size();
+}
+
+ParallelGroup::ParallelGroup(std::vector<CommandPtr> commands, const std::string& name)
+	: CommandGroup(name, std::move(commands)) {}
+
+void ParallelGroup::initialize() {
+	done = false;
+	for (CommandPtr& command : commands) {
+		command->start(time());
+	}
+}
+
+void ParallelGroup::execute() {
+	done = true;
+	for (CommandPtr& command : commands) {
+		if (!command->update(time())) {
+			done = false;
+		}
+	}
+}
+
+bool ParallelGroup::isFinished() {
+	return done;
+}
+
+RaceGroup::RaceGroup(std::vector<CommandPtr> commands, const std::string& name)
+	: CommandGroup(name, std::move(commands)) {}
+
+void RaceGroup::initialize() {
+	done = commands.empty();
+	for (CommandPtr& command : commands) {
+		command->start(time());
+	}
+}
+
+void RaceGroup::execute() {
+	for (CommandPtr& command : commands) {
+		if (command->update(time())) {
+			done = true;
+		}
+	}
+}
+
+bool RaceGroup::isFinished() {
+	return done;
+}
+
+DeadlineGroup::DeadlineGroup(std::vector<CommandPtr> commands, const std::string& name)
+	: CommandGroup(name, std::move(commands)) {}
+
+void DeadlineGroup::initialize() {
+	done = commands.empty();
+	for (CommandPtr& command : commands) {
+		command->start(time());
+	}
+}
+
+void DeadlineGroup::execute() {
+	for (size_t i = 0; i < commands.size(); i++) {
+		if (commands[i]->update(time()) && i == 0) {
+			done = true;
+		}
+	}
+}
+
+bool DeadlineGroup::isFinished() {
+	return done;
+}
+
+GuardCommand::GuardCommand(const std::string& condition_name, std::function<bool()> condition, CommandPtr body,
+                           CommandPtr recovery)
+	: CommandGroup("unless " + condition_name, {}), condition(condition) {
+	commands.push_back(std::move(body));
+	if (recovery) {
+		commands.push_back(std::move(recovery));
+	}
+}
+
+bool GuardCommand::wasTripped() const {
+	return tripped;
+}
+
+void GuardCommand::initialize() {
+	tripped = false;
+	done = false;
+	commands[0]->start(time());
+}
+
+void GuardCommand::execute() {
+	if (!tripped) {
+		if (!condition()) {
+			done = commands[0]->update(time());
+			return;
+		}
+		commands[0]->cancel(time());
+		tripped = true;
+		if (commands.size() < 2) {
+			done = true;
+			return;
+		}
+		commands[1]->start(time());
+	}
+	done = commands[1]->update(time());
+}
+
+bool GuardCommand::isFinished() {
+	return done;
+}
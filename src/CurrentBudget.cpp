@@ -0,0 +1,129 @@
+#include "CurrentBudget.h"
+#include "Telemetry.h"
+#include <algorithm>
+#include <cstdlib>
+
+CurrentBudget::CurrentBudget(int total_ma, int motor_max_ma, int motor_min_ma)
+	: total_ma(total_ma), motor_max_ma(motor_max_ma), motor_min_ma(motor_min_ma) {}
+
+void CurrentBudget::addMotor(pros::Motor* motor, Subsystem subsystem) {
+	motors.push_back({motor, subsystem, motor_max_ma, motor_max_ma, -1});
+}
+
+void CurrentBudget::setPriority(Subsystem subsystem) {
+	if (first == subsystem) {
+		return;
+	}
+	first = subsystem;
+	telemetry_log("current", "priority %s", subsystemName(subsystem));
+}
+
+Subsystem CurrentBudget::getPriority() const {
+	return first;
+}
+
+void CurrentBudget::update() {
+	Subsystem order[NUM_SUBSYSTEMS] = {first};
+	int n = 1;
+	for (int s = 0; s < NUM_SUBSYSTEMS; s++) {
+		if (s != order[0]) {
+			order[n++] = (Subsystem)s;
+		}
+	}
+
+	// every motor keeps a floor so nothing stalls outright, the rest of the
+	// budget is handed out in priority order
+	int remaining = total_ma - motor_min_ma * (int)motors.size();
+	for (Entry& entry : motors) {
+		int draw = entry.motor->get_current_draw();
+		if (draw == PROS_ERR) {
+			draw = 0;
+		}
+		// headroom above the present draw lets a motor ramp up over a few ticks
+		entry.demand = std::clamp(draw * 5 / 4 + 250, motor_min_ma, motor_max_ma);
+		entry.limit = motor_min_ma;
+	}
+
+	bool now_limited[NUM_SUBSYSTEMS] = {};
+	for (Subsystem subsystem : order) {
+		int need = 0;
+		for (Entry& entry : motors) {
+			if (entry.subsystem == subsystem) {
+				need += entry.demand - motor_min_ma;
+			}
+		}
+		if (need <= 0) {
+			continue;
+		}
+		// not enough left: scale every motor in the group down evenly
+		int granted = std::min(need, std::max(remaining, 0));
+		for (Entry& entry : motors) {
+			if (entry.subsystem == subsystem) {
+				entry.limit += (int)((long)(entry.demand - motor_min_ma) * granted / need);
+			}
+		}
+		remaining -= granted;
+		if (granted < need) {
+			now_limited[subsystem] = true;
+		}
+	}
+
+	// spread whatever is left so idle motors can still respond quickly
+	if (remaining > 0 && !motors.empty()) {
+		int share = remaining / (int)motors.size();
+		for (Entry& entry : motors) {
+			entry.limit = std::min(entry.limit + share, motor_max_ma);
+		}
+	}
+
+	for (Entry& entry : motors) {
+		if (entry.applied < 0 || std::abs(entry.limit - entry.applied) > 50) {
+			entry.motor->set_current_limit(entry.limit);
+			entry.applied = entry.limit;
+		}
+	}
+
+	uint32_t now = pros::millis();
+	for (int s = 0; s < NUM_SUBSYSTEMS; s++) {
+		if (now_limited[s]) {
+			limited_ticks[s]++;
+		}
+		if (now_limited[s] != limited[s]) {
+			telemetry_log("current", "%s %s", subsystemName((Subsystem)s), now_limited[s] ? "limited" : "released");
+		}
+		limited[s] = now_limited[s];
+	}
+
+	// periodic summary while anything is being held back
+	if ((limited[0] || limited[1] || limited[2]) && now - last_report >= 250) {
+		int draw_total = 0;
+		for (Entry& entry : motors) {
+			draw_total += entry.demand;
+		}
+		telemetry_log("current", "demand %d budget %d drive %lu flywheel %lu intake %lu", draw_total, total_ma,
+		              (unsigned long)limited_ticks[SUBSYSTEM_DRIVE], (unsigned long)limited_ticks[SUBSYSTEM_FLYWHEEL],
+		              (unsigned long)limited_ticks[SUBSYSTEM_INTAKE]);
+		last_report = now;
+	}
+}
+
+void CurrentBudget::start(uint32_t period_ms) {
+	if (task != nullptr) {
+		return;
+	}
+	task = new pros::Task([this, period_ms] {
+		uint32_t time = pros::millis();
+		while (true) {
+			update();
+			pros::Task::delay_until(&time, period_ms);
+		}
+	}, "current budget");
+}
+
+bool CurrentBudget::isLimited(Subsystem subsystem) const {
+	return limited[subsystem];
+}
+
+uint32_t CurrentBudget::getLimitedTicks(Subsystem subsystem) const {
+	return limited_ticks[subsystem];
+}
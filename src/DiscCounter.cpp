@@ -0,0 +1,71 @@
+#include "DiscCounter.h"
+
+DiscCounter::DiscCounter(int intake_threshold, int indexer_threshold, uint32_t debounce_ms)
+	: intake_threshold(intake_threshold), indexer_threshold(indexer_threshold), debounce_ms(debounce_ms) {}
+
+bool DiscCounter::updateBeam(Beam& beam, int mm, int threshold, uint32_t now) {
+	beam.valid = mm >= 0;
+	if (!beam.valid) {
+		beam.present = false;
+		return false;
+	}
+	bool raw = mm < threshold;
+	if (raw != beam.raw) {
+		beam.raw = raw;
+		beam.changed = now;
+	}
+	if (beam.raw == beam.present || now - beam.changed < debounce_ms) {
+		return false;
+	}
+	beam.present = beam.raw;
+	return beam.present;
+}
+
+void DiscCounter::update(int intake_mm, int indexer_mm, int intake_direction, uint32_t now) {
+	if (updateBeam(intake, intake_mm, intake_threshold, now)) {
+		if (intake_direction > 0 && count < MAX_DISCS) {
+			count++;
+		}
+		else if (intake_direction < 0 && count > 0) {
+			count--;
+		}
+	}
+	updateBeam(indexer, indexer_mm, indexer_threshold, now);
+	// a seated disc means at least one, whatever the intake count says
+	if (indexer.present && count == 0) {
+		count = 1;
+	}
+}
+
+bool DiscCounter::canFire() const {
+	if (indexer.valid) {
+		return indexer.present;
+	}
+	if (intake.valid) {
+		return count > 0;
+	}
+	return true;
+}
+
+bool DiscCounter::recordShot() {
+	bool fired = canFire();
+	if (fired && count > 0) {
+		count--;
+	}
+	// the seated disc has gone, wait for the sensor to see the next one
+	indexer.present = false;
+	indexer.raw = false;
+	return fired;
+}
+
+int DiscCounter::getCount() const {
+	return count;
+}
+
+bool DiscCounter::hasSensors() const {
+	return intake.valid || indexer.valid;
+}
+
+void DiscCounter::setCount(int new_count) {
+	count = new_count < 0 ? 0 : new_count > MAX_DISCS ? MAX_DISCS : new_count;
+}
@@ -0,0 +1,104 @@
+#include "DriveController.h"
+#include "HeadingHold.h"
+#include <algorithm>
+#include <cmath>
+
+DriveController::DriveController(double ticks_per_inch, const DriveGains& gains, double tolerance,
+                                 uint32_t settle_ms, uint32_t timeout_extra_ms)
+	: ticks_per_inch(ticks_per_inch), gains(gains), tolerance(tolerance), settle_ms(settle_ms),
+	  timeout_extra_ms(timeout_extra_ms) {}
+
+void DriveController::start(double forward, double right, double fl, double fr, double bl, double br,
+                            double heading, uint32_t now) {
+	double length = std::hypot(forward, right);
+	profile = MotionProfile(length, gains.limits);
+	unit_forward = length > 0 ? forward / length : 1;
+	unit_right = length > 0 ? right / length : 0;
+	start_wheels[0] = fl;
+	start_wheels[1] = fr;
+	start_wheels[2] = bl;
+	start_wheels[3] = br;
+	start_heading = heading;
+	start_time = now;
+	last_time = now;
+	settled_since = now;
+	last_progress = 0;
+	speed = 0;
+	error = length;
+	forward_out = right_out = rotation_out = 0;
+	settled = false;
+	timed_out = false;
+}
+
+void DriveController::update(double fl, double fr, double bl, double br, double heading, uint32_t now) {
+	// same kinematics as Odometry, in the robot frame since the start
+	double dfl = fl - start_wheels[0], dfr = fr - start_wheels[1];
+	double dbl = bl - start_wheels[2], dbr = br - start_wheels[3];
+	double forward = (dfl - dfr + dbl - dbr) / 4 / ticks_per_inch;
+	double right = (dfl + dfr - dbl - dbr) / 4 / ticks_per_inch;
+	double progress = forward * unit_forward + right * unit_right;
+	double across = right * unit_forward - forward * unit_right;
+
+	if (now > last_time) {
+		speed = 0.6 * speed + 0.4 * (progress - last_progress) / ((now - last_time) / 1000.0);
+	}
+	last_progress = progress;
+	last_time = now;
+
+	double t = (now - start_time) / 1000.0;
+	ProfileState state = profile.sample(t);
+	error = profile.getDistance() - progress;
+
+	bool profile_done = t >= profile.getDuration();
+	if (!profile_done || std::fabs(error) > tolerance) {
+		settled_since = now;
+	}
+	settled = profile_done && now - settled_since >= settle_ms;
+	timed_out = t >= profile.getDuration() + timeout_extra_ms / 1000.0;
+	if (isFinished()) {
+		forward_out = right_out = rotation_out = 0;
+		return;
+	}
+
+	double along = gains.kV * state.velocity + gains.kA * state.acceleration
+		+ gains.kP * (state.position - progress) + gains.kD * (state.velocity - speed);
+	if (std::fabs(state.velocity) > 0 || std::fabs(error) > tolerance) {
+		along += std::copysign(gains.kS, std::fabs(state.velocity) > 0 ? state.velocity : error);
+	}
+	double correction = -gains.kP * across;
+	forward_out = along * unit_forward - correction * unit_right;
+	right_out = along * unit_right + correction * unit_forward;
+	rotation_out = std::clamp(gains.kP_heading * wrapDegrees(start_heading - heading), -127.0, 127.0);
+}
+
+double DriveController::getForward() const {
+	return forward_out;
+}
+
+double DriveController::getRight() const {
+	return right_out;
+}
+
+double DriveController::getRotation() const {
+	return rotation_out;
+}
+
+bool DriveController::isSettled() const {
+	return settled;
+}
+
+bool DriveController::isTimedOut() const {
+	return timed_out;
+}
+
+bool DriveController::isFinished() const {
+	return settled || timed_out;
+}
+
+double DriveController::getError() const {
+	return error;
+}
+
+double DriveController::getDuration() const {
+	return profile.getDuration();
+}
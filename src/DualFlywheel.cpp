@@ -0,0 +1,215 @@
+#include "DualFlywheel.h"
+#include <algorithm>
+#include <cmath>
+
+// tuned on DualFlywheelSimulator with host/flywheel_sync
+const FlywheelGains DEFAULT_FLYWHEEL_GAINS = {
+	56,  // kV
+	450, // kS1
+	450, // kS2
+	60,  // kP
+	400, // kI
+	40,  // kP_diff
+	300, // kI_diff
+};
+
+DualFlywheel::DualFlywheel(const FlywheelGains& gains, double max_mv) : gains(gains), max_mv(max_mv) {}
+
+void DualFlywheel::setTarget(double rpm) {
+	if (rpm == 0) {
+		reset();
+	}
+	target = rpm;
+}
+
+double DualFlywheel::getTarget() const {
+	return target;
+}
+
+void DualFlywheel::update(double rpm1, double rpm2, double dt) {
+	average = (rpm1 + rpm2) / 2;
+	difference = rpm1 - rpm2;
+	if (target == 0) {
+		voltage1 = voltage2 = 0;
+		return;
+	}
+
+	double sign = target > 0 ? 1 : -1;
+	double feedforward = gains.kV * target * feedforward_scale;
+	double average_error = target - average;
+	double difference_error = -difference;
+
+	double common = feedforward + gains.kP * average_error + gains.kI * average_integral;
+	double split = gains.kP_diff * difference_error + gains.kI_diff * difference_integral;
+	double out1 = common + sign * gains.kS1 * feedforward_scale + split / 2;
+	double out2 = common + sign * gains.kS2 * feedforward_scale - split / 2;
+
+	// only integrate while neither motor is saturated, or the error is
+	// pulling the output back in
+	bool saturated1 = std::fabs(out1) >= max_mv;
+	bool saturated2 = std::fabs(out2) >= max_mv;
+	if ((!saturated1 && !saturated2) || average_error * common < 0) {
+		average_integral += average_error * dt;
+	}
+	if ((!saturated1 && !saturated2) || difference_error * split < 0) {
+		difference_integral += difference_error * dt;
+	}
+
+	voltage1 = std::clamp(out1, -max_mv, max_mv);
+	voltage2 = std::clamp(out2, -max_mv, max_mv);
+}
+
+double DualFlywheel::getVoltage1() const {
+	return voltage1;
+}
+
+double DualFlywheel::getVoltage2() const {
+	return voltage2;
+}
+
+double DualFlywheel::getAverage() const {
+	return average;
+}
+
+double DualFlywheel::getDifference() const {
+	return difference;
+}
+
+void DualFlywheel::setFeedforwardScale(double scale) {
+	feedforward_scale = scale;
+}
+
+void DualFlywheel::setGains(const FlywheelGains& new_gains) {
+	gains = new_gains;
+}
+
+const FlywheelGains& DualFlywheel::getGains() const {
+	return gains;
+}
+
+void DualFlywheel::reset() {
+	average_integral = 0;
+	difference_integral = 0;
+	voltage1 = voltage2 = 0;
+}
+
+// V5 motor with the 200 rpm cartridge
+const double STALL_TORQUE = 2.1;                    // N m
+const double FREE_SPEED = 200 * 2 * M_PI / 60;      // rad/s
+const double MAX_MV = 12000;
+const double REFERENCE_BATTERY = 12600; // mV
+
+DualFlywheelSimulator::DualFlywheelSimulator(double inertia, double coupling, double timestep)
+	: inertia(inertia), coupling(coupling), timestep(timestep) {}
+
+void DualFlywheelSimulator::setVoltage(double mv1, double mv2) {
+	voltage[0] = std::clamp(mv1, -MAX_MV, MAX_MV);
+	voltage[1] = std::clamp(mv2, -MAX_MV, MAX_MV);
+}
+
+double DualFlywheelSimulator::sideTorque(int side, double coupling_torque) const {
+	double applied = voltage[side] / MAX_MV * battery / REFERENCE_BATTERY;
+	double motor = strength[side] * STALL_TORQUE * (applied - omega[side] / FREE_SPEED);
+	double drive = motor + coupling_torque;
+	if (omega[side] == 0) {
+		// static friction holds the side still until the drive overcomes it
+		if (std::fabs(drive) <= static_friction[side]) {
+			return 0;
+		}
+		return drive - std::copysign(static_friction[side], drive);
+	}
+	return drive - std::copysign(dynamic_friction[side], omega[side]);
+}
+
+void DualFlywheelSimulator::step() {
+	if (fitted) {
+		for (int i = 0; i < 2; i++) {
+			double applied = voltage[i] * battery / REFERENCE_BATTERY;
+			double rpm = omega[i] * 60 / (2 * M_PI);
+			double drive = applied - model.kV[i] * rpm;
+			double accel;
+			if (omega[i] == 0 && std::fabs(applied) <= model.kS[i]) {
+				accel = 0;
+			}
+			else {
+				double direction = omega[i] != 0 ? omega[i] : applied;
+				accel = (drive - std::copysign(model.kS[i], direction)) / model.kA[i];
+			}
+			double next = omega[i] + accel * 2 * M_PI / 60 * timestep;
+			if (omega[i] != 0 && next * omega[i] < 0) {
+				next = 0;
+			}
+			omega[i] = next;
+		}
+		return;
+	}
+
+	double coupling_torque = coupling * twist; // pulls side 1 back, side 2 forward
+	double torque[2] = {sideTorque(0, -coupling_torque), sideTorque(1, coupling_torque)};
+	for (int i = 0; i < 2; i++) {
+		double next = omega[i] + torque[i] / inertia * timestep;
+		// friction can stop a side but not reverse it
+		if (omega[i] != 0 && next * omega[i] < 0) {
+			next = 0;
+		}
+		omega[i] = next;
+	}
+	twist += (omega[0] - omega[1]) * timestep;
+}
+
+void DualFlywheelSimulator::setStaticFriction(double friction1, double friction2) {
+	static_friction[0] = friction1;
+	static_friction[1] = friction2;
+}
+
+void DualFlywheelSimulator::setDynamicFriction(double friction1, double friction2) {
+	dynamic_friction[0] = friction1;
+	dynamic_friction[1] = friction2;
+}
+
+void DualFlywheelSimulator::setStrength(double strength1, double strength2) {
+	strength[0] = strength1;
+	strength[1] = strength2;
+}
+
+void DualFlywheelSimulator::setCoupling(double stiffness) {
+	coupling = stiffness;
+}
+
+void DualFlywheelSimulator::setBattery(double battery_mv) {
+	battery = battery_mv;
+}
+
+void DualFlywheelSimulator::setTimestep(double new_timestep) {
+	timestep = new_timestep;
+}
+
+void DualFlywheelSimulator::setModel(const FlywheelModel& new_model) {
+	model = new_model;
+	fitted = true;
+}
+
+void DualFlywheelSimulator::shoot(double energy_fraction) {
+	// kinetic energy goes with omega squared
+	double scale = std::sqrt(1 - energy_fraction);
+	omega[0] *= scale;
+	omega[1] *= scale;
+}
+
+void DualFlywheelSimulator::setRpm(double rpm1, double rpm2) {
+	omega[0] = rpm1 * 2 * M_PI / 60;
+	omega[1] = rpm2 * 2 * M_PI / 60;
+	twist = 0;
+}
+
+double DualFlywheelSimulator::getRpm1() const {
+	return omega[0] * 60 / (2 * M_PI);
+}
+
+double DualFlywheelSimulator::getRpm2() const {
+	return omega[1] * 60 / (2 * M_PI);
+}
+
+double DualFlywheelSimulator::getTimestep() const {
+	return timestep;
+}
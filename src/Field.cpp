@@ -0,0 +1,29 @@
+#include "Field.h"
+#include <cmath>
+
+const RollerPosition ROLLERS[NUM_ROLLERS] = {
+	{-46.8, -FIELD_HALF_SIZE, 180},
+	{-FIELD_HALF_SIZE, -46.8, 270},
+	{46.8, FIELD_HALF_SIZE, 0},
+	{FIELD_HALF_SIZE, 46.8, 90},
+};
+
+void goalPosition(Alliance alliance, double& x, double& y) {
+	if (alliance == ALLIANCE_RED) {
+		x = RED_GOAL_X;
+		y = RED_GOAL_Y;
+	}
+	else {
+		x = BLUE_GOAL_X;
+		y = BLUE_GOAL_Y;
+	}
+}
+
+Wall wallAhead(double heading) {
+	int quarter = (int)std::lround(heading / 90) % 4;
+	return (Wall)(quarter < 0 ? quarter + 4 : quarter);
+}
+
+double wallHeading(Wall wall) {
+	return wall * 90.0;
+}
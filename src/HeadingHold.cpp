@@ -0,0 +1,70 @@
+#include "HeadingHold.h"
+#include <algorithm>
+#include <cmath>
+
+double wrapDegrees(double angle) {
+	angle = std::fmod(angle + 180, 360);
+	if (angle < 0) {
+		angle += 360;
+	}
+	return angle - 180;
+}
+
+HeadingHold::HeadingHold(double deadband, double kP, double kD,
+                         double max_output, uint32_t relatch_ms, double settled_rate)
+	: deadband(std::max(deadband, MIN_LATCH_DEADBAND)), kP(kP), kD(kD), max_output(max_output),
+	  relatch_ms(relatch_ms), settled_rate(settled_rate) {}
+
+double HeadingHold::update(double stick, double r, double heading, uint32_t now) {
+	// yaw rate from successive headings, lightly filtered
+	if (has_last && now > last_time) {
+		double dt = (now - last_time) / 1000.0;
+		double raw_rate = wrapDegrees(heading - last_heading) / dt;
+		rate = 0.7 * rate + 0.3 * raw_rate;
+	}
+	last_heading = heading;
+	last_time = now;
+	has_last = true;
+
+	// driver is turning: pass the shaped stick through and re-arm the latch
+	if (std::fabs(stick) > deadband) {
+		holding = false;
+		release_time = now;
+		return r;
+	}
+
+	if (!holding) {
+		// latch once the robot has stopped turning, or after the timeout
+		if (std::fabs(rate) < settled_rate || now - release_time >= relatch_ms) {
+			target = heading;
+			holding = true;
+		}
+		else {
+			return 0;
+		}
+	}
+
+	double error = wrapDegrees(target - heading);
+	double output = kP * error - kD * rate;
+	if (output > max_output) {
+		output = max_output;
+	}
+	else if (output < -max_output) {
+		output = -max_output;
+	}
+	return output;
+}
+
+void HeadingHold::reset() {
+	holding = false;
+	has_last = false;
+	rate = 0;
+}
+
+bool HeadingHold::isHolding() const {
+	return holding;
+}
+
+double HeadingHold::getTarget() const {
+	return target;
+}
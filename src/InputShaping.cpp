@@ -0,0 +1,145 @@
+#include "InputShaping.h"
+#include <cmath>
+
+// Driver profiles, pick one from the brain screen before the match.
+// Slew rates are in stick units per second: 1270 reaches full stick in 100 ms.
+const DriverProfile DRIVER_PROFILES[] = {
+	{"Default",
+		{5, CURVE_LINEAR, 0, 1270, 2540},
+		{5, CURVE_LINEAR, 0, 1270, 2540},
+		{5, CURVE_LINEAR, 0, 0, 0}},
+	{"Precise",
+		{8, CURVE_CUBIC, 0.6, 900, 2000},
+		{8, CURVE_CUBIC, 0.6, 900, 2000},
+		{8, CURVE_CUBIC, 0.7, 1500, 0}},
+	{"Aggressive",
+		{4, CURVE_EXPONENTIAL, 2, 2000, 4000},
+		{4, CURVE_EXPONENTIAL, 2, 2000, 4000},
+		{4, CURVE_EXPONENTIAL, 2.5, 0, 0}},
+	{"Raw",
+		{0, CURVE_LINEAR, 0, 0, 0},
+		{0, CURVE_LINEAR, 0, 0, 0},
+		{0, CURVE_LINEAR, 0, 0, 0}},
+};
+
+const int NUM_DRIVER_PROFILES = sizeof(DRIVER_PROFILES) / sizeof(DRIVER_PROFILES[0]);
+
+double applyDeadband(double in, double deadband) {
+	double mag = std::fabs(in);
+	if (mag <= deadband) {
+		return 0;
+	}
+	if (mag > 127) {
+		mag = 127;
+	}
+	double out = (mag - deadband) * 127 / (127 - deadband);
+	return in < 0 ? -out : out;
+}
+
+double applyCurve(double in, CurveType curve, double expo) {
+	double n = in / 127; // normalized -1..1
+	double mag = std::fabs(n);
+	double out;
+
+	switch (curve) {
+		case CURVE_CUBIC:
+			out = (1 - expo) * mag + expo * mag * mag * mag;
+			break;
+		case CURVE_EXPONENTIAL:
+			if (expo <= 0) {
+				out = mag;
+			}
+			else {
+				out = (std::exp(expo * mag) - 1) / (std::exp(expo) - 1);
+			}
+			break;
+		case CURVE_LINEAR:
+		default:
+			out = mag;
+			break;
+	}
+	return (n < 0 ? -out : out) * 127;
+}
+
+AxisShaper::AxisShaper(const AxisShape& shape) : shape(shape) {}
+
+// accel slew while the wheels slip on an axis with no limit of its own
+const double SLIP_SLEW = 1270;
+
+double AxisShaper::update(double in, double dt, double traction) {
+	double target = applyCurve(applyDeadband(in, shape.deadband), shape.curve, shape.expo);
+	// slipping wheels get no more push than they can use: the output may only
+	// build up as fast as traction allows, slowing down is never held back
+	double accel_slew = shape.accel_slew;
+	if (traction < 1) {
+		accel_slew = (accel_slew > 0 ? accel_slew : SLIP_SLEW) * std::fmax(traction, 0.0);
+	}
+
+	// slowing down (including the first half of a reversal) uses the decel
+	// limit, speeding up away from zero uses the accel limit
+	bool same_side = (target >= 0 && output >= 0) || (target <= 0 && output <= 0);
+	if (same_side && std::fabs(target) >= std::fabs(output)) {
+		double step = accel_slew * dt;
+		if ((accel_slew <= 0 && traction >= 1) || std::fabs(target - output) <= step) {
+			output = target;
+		}
+		else {
+			output += target > output ? step : -step;
+		}
+	}
+	else {
+		// never overshoot zero in one step while reversing
+		double goal = same_side ? target : 0;
+		double step = shape.decel_slew * dt;
+		if (shape.decel_slew <= 0 || std::fabs(goal - output) <= step) {
+			output = goal;
+		}
+		else {
+			output += goal > output ? step : -step;
+		}
+	}
+	return output;
+}
+
+void AxisShaper::setShape(const AxisShape& new_shape) {
+	shape = new_shape;
+}
+
+void AxisShaper::reset() {
+	output = 0;
+}
+
+InputShaper::InputShaper(const DriverProfile& profile)
+	: x_shaper(profile.x), y_shaper(profile.y), r_shaper(profile.r) {}
+
+void InputShaper::update(double raw_x, double raw_y, double raw_r, double dt, double traction) {
+	// the sticks are field-centric, so both follow the worse robot axis
+	x = x_shaper.update(raw_x, dt, traction);
+	y = y_shaper.update(raw_y, dt, traction);
+	r = r_shaper.update(raw_r, dt);
+}
+
+void InputShaper::setProfile(const DriverProfile& profile) {
+	x_shaper.setShape(profile.x);
+	y_shaper.setShape(profile.y);
+	r_shaper.setShape(profile.r);
+}
+
+void InputShaper::reset() {
+	x_shaper.reset();
+	y_shaper.reset();
+	r_shaper.reset();
+	x = y = r = 0;
+}
+
+double InputShaper::getX() const {
+	return x;
+}
+
+double InputShaper::getY() const {
+	return y;
+}
+
+double InputShaper::getR() const {
+	return r;
+}
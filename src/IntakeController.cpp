@@ -0,0 +1,88 @@
+#include "IntakeController.h"
+#include <cmath>
+
+const double STALL_SPEED_RATIO = 0.2; // below this fraction of the command counts as not moving
+const int STALL_CURRENT = 1500;       // mA
+const uint32_t SPINUP_MS = 200;       // ignore the first moments after starting
+const uint32_t RECOVERED_MS = 500;    // running clean this long resets the retry count
+const double UNJAM_SPEED = 0.5;
+
+IntakeController::IntakeController(uint32_t jam_ms, uint32_t unjam_ms, int max_retries)
+	: jam_ms(jam_ms), unjam_ms(unjam_ms), max_retries(max_retries) {}
+
+double IntakeController::update(double command, const double speed[INTAKE_MOTORS],
+                                const int current[INTAKE_MOTORS], uint32_t now) {
+	// a new command (or letting go) starts over
+	bool new_command = (command > 0) != (last_command > 0) || (command < 0) != (last_command < 0);
+	last_command = command;
+	if (command == 0 || new_command) {
+		state = INTAKE_RUNNING;
+		run_start = now;
+		stalled = false;
+		retries = 0;
+		clear_since = now;
+		if (command == 0) {
+			return 0;
+		}
+	}
+
+	double direction = command > 0 ? 1 : -1;
+	switch (state) {
+		case INTAKE_RUNNING: {
+			bool any_stalled = false;
+			for (int i = 0; i < INTAKE_MOTORS; i++) {
+				if (speed[i] * direction < STALL_SPEED_RATIO * std::fabs(command) && current[i] > STALL_CURRENT) {
+					any_stalled = true;
+				}
+			}
+			if (!any_stalled || now - run_start < SPINUP_MS) {
+				stalled = false;
+				if (now - clear_since >= RECOVERED_MS) {
+					retries = 0;
+				}
+				return command;
+			}
+			if (!stalled) {
+				stalled = true;
+				stall_start = now;
+			}
+			clear_since = now;
+			if (now - stall_start < jam_ms) {
+				return command;
+			}
+			jams++;
+			stalled = false;
+			if (++retries > max_retries) {
+				stall_outs++;
+				state = INTAKE_STALLED_OUT;
+				return 0;
+			}
+			state = INTAKE_UNJAMMING;
+			unjam_start = now;
+			return -direction * UNJAM_SPEED;
+		}
+		case INTAKE_UNJAMMING:
+			if (now - unjam_start < unjam_ms) {
+				return -direction * UNJAM_SPEED;
+			}
+			state = INTAKE_RUNNING;
+			run_start = now;
+			clear_since = now;
+			return command;
+		case INTAKE_STALLED_OUT:
+		default:
+			return 0;
+	}
+}
+
+IntakeState IntakeController::getState() const {
+	return state;
+}
+
+uint32_t IntakeController::getJams() const {
+	return jams;
+}
+
+uint32_t IntakeController::getStallOuts() const {
+	return stall_outs;
+}
@@ -0,0 +1,121 @@
+#include "Localization.h"
+#include "HeadingHold.h"
+#include <cmath>
+
+// tuning
+const double SLIP_VARIANCE_PER_INCH = 0.05; // in^2 of drift per inch driven
+const double SLIPPING_VARIANCE_SCALE = 5;   // how much worse that gets with no traction
+const double STEP_VARIANCE = 0.0005;        // in^2 per tick even when still
+const double MIN_GPS_ERROR = 0.5;           // inches, floor on the sensor's claim
+const double MAX_GPS_ERROR = 4;             // inches, worse fixes are ignored
+const double GATE = 11.8;                   // chi-square, 2 dof, 99.7%
+const int STALE_AFTER = 10;                 // identical fixes in a row before the sensor counts as stale
+const int REOPEN_AFTER = 10;                // disagreeing fixes before the estimate is reopened
+const double REOPEN_VARIANCE = 144;         // 12 in standard deviation
+const double HEADING_GAIN = 0.02;           // fraction of GPS heading error taken per fix
+
+Localization::Localization() {}
+
+void Localization::predict(double forward, double right, double imu_heading, double traction) {
+	if (!has_imu) {
+		heading_offset = pose.heading - imu_heading;
+		last_imu = imu_heading;
+		has_imu = true;
+	}
+	double turn = wrapDegrees(imu_heading - last_imu);
+	last_imu = imu_heading;
+	double heading = imu_heading + heading_offset;
+	double mid = (heading - turn / 2) * M_PI / 180;
+
+	pose.x += right * std::cos(mid) + forward * std::sin(mid);
+	pose.y += forward * std::cos(mid) - right * std::sin(mid);
+	pose.heading = heading;
+	double slip_scale = 1 + (SLIPPING_VARIANCE_SCALE - 1) * (1 - std::fmin(std::fmax(traction, 0.0), 1.0));
+	variance += SLIP_VARIANCE_PER_INCH * slip_scale * std::hypot(forward, right) + STEP_VARIANCE;
+}
+
+bool Localization::correct(const GpsFix& fix) {
+	if (!fix.valid || fix.error > MAX_GPS_ERROR) {
+		rejected++;
+		return false;
+	}
+	// polled faster than the sensor updates, so repeats are skipped; a sensor
+	// that keeps repeating itself has stopped updating
+	if (fix.x == last_fix_x && fix.y == last_fix_y) {
+		if (++repeated_fixes > STALE_AFTER) {
+			rejected++;
+		}
+		return false;
+	}
+	repeated_fixes = 0;
+	last_fix_x = fix.x;
+	last_fix_y = fix.y;
+
+	double measurement_variance = std::pow(std::fmax(fix.error, MIN_GPS_ERROR), 2);
+	double dx = fix.x - pose.x;
+	double dy = fix.y - pose.y;
+	double distance2 = (dx * dx + dy * dy) / (variance + measurement_variance);
+	if (distance2 > GATE) {
+		rejected++;
+		if (++disagreeing_fixes >= REOPEN_AFTER) {
+			variance = REOPEN_VARIANCE;
+			disagreeing_fixes = 0;
+		}
+		return false;
+	}
+	disagreeing_fixes = 0;
+
+	double gain = variance / (variance + measurement_variance);
+	pose.x += gain * dx;
+	pose.y += gain * dy;
+	variance *= 1 - gain;
+
+	// the IMU is trusted for heading changes, GPS only trims its offset
+	heading_offset += HEADING_GAIN * (MIN_GPS_ERROR / std::fmax(fix.error, MIN_GPS_ERROR))
+		* wrapDegrees(fix.heading - pose.heading);
+	accepted++;
+	return true;
+}
+
+void Localization::reset(const Pose& new_pose) {
+	pose = new_pose;
+	has_imu = false;
+	variance = 1;
+	disagreeing_fixes = 0;
+}
+
+Pose Localization::getPose() const {
+	return pose;
+}
+
+double Localization::getStdDev() const {
+	return std::sqrt(variance);
+}
+
+uint32_t Localization::getAccepted() const {
+	return accepted;
+}
+
+uint32_t Localization::getRejected() const {
+	return rejected;
+}
+
+SimulatedGps::SimulatedGps(double noise, double dropout, double outlier, unsigned seed)
+	: noise(noise), dropout(dropout), outlier(outlier), rng(seed) {}
+
+GpsFix SimulatedGps::read(const Pose& truth) {
+	std::uniform_real_distribution<double> chance(0, 1);
+	std::normal_distribution<double> gaussian(0, noise);
+	GpsFix fix = {true, truth.x + gaussian(rng), truth.y + gaussian(rng),
+	              truth.heading + gaussian(rng), noise};
+	double roll = chance(rng);
+	if (roll < dropout) {
+		fix.valid = false;
+	}
+	else if (roll < dropout + outlier) {
+		// reflection off a robot or the field: confident but wrong
+		fix.x += 30 * (chance(rng) - 0.5);
+		fix.y += 30 * (chance(rng) - 0.5);
+	}
+	return fix;
+}
@@ -0,0 +1,104 @@
+#include "MotionProfile.h"
+#include <algorithm>
+#include <cmath>
+
+MotionProfile::Ramp MotionProfile::planRamp(double velocity, double max_accel, double max_jerk) {
+	Ramp ramp;
+	// without room for a constant-acceleration stretch the peak is lower
+	ramp.accel = max_jerk > 0 ? std::min(max_accel, std::sqrt(velocity * max_jerk)) : max_accel;
+	ramp.jerk_time = max_jerk > 0 ? ramp.accel / max_jerk : 0;
+	ramp.duration = velocity / ramp.accel + ramp.jerk_time;
+	return ramp;
+}
+
+MotionProfile::MotionProfile(double distance, const ProfileLimits& limits)
+	: distance(distance), sign(distance < 0 ? -1 : 1) {
+	double length = std::fabs(distance);
+	// a ramp is symmetric in time, so it covers its peak speed times half its duration
+	auto ramps_length = [&](double velocity) {
+		return velocity * (planRamp(velocity, limits.max_accel, limits.max_jerk).duration
+			+ planRamp(velocity, limits.max_decel, limits.max_jerk).duration) / 2;
+	};
+
+	peak_velocity = limits.max_velocity;
+	if (ramps_length(peak_velocity) > length) {
+		// too short to cruise; the ramps' length grows with the peak, so bisect
+		// for the peak that uses exactly the whole move (once, at planning)
+		double low = 0, high = peak_velocity;
+		for (int i = 0; i < 50; i++) {
+			double mid = (low + high) / 2;
+			(ramps_length(mid) > length ? high : low) = mid;
+		}
+		peak_velocity = low;
+	}
+
+	if (peak_velocity <= 0) {
+		up = down = {1, 0, 0};
+		cruise_time = 0;
+		return;
+	}
+	up = planRamp(peak_velocity, limits.max_accel, limits.max_jerk);
+	down = planRamp(peak_velocity, limits.max_decel, limits.max_jerk);
+	cruise_time = std::max(0.0, (length - ramps_length(peak_velocity)) / peak_velocity);
+}
+
+// state t into a ramp from rest: jerk up, constant acceleration, jerk down
+ProfileState MotionProfile::sampleRamp(const Ramp& ramp, double t) const {
+	double a = ramp.accel;
+	double tj = ramp.jerk_time;
+	double tc = ramp.duration - 2 * tj;
+	double jerk = tj > 0 ? a / tj : 0;
+
+	if (t >= ramp.duration) {
+		return {peak_velocity * ramp.duration / 2, peak_velocity, 0};
+	}
+	if (t < tj) {
+		return {jerk * t * t * t / 6, jerk * t * t / 2, jerk * t};
+	}
+	double v1 = a * tj / 2;
+	double p1 = a * tj * tj / 6;
+	if (t < tj + tc) {
+		double dt = t - tj;
+		return {p1 + v1 * dt + a * dt * dt / 2, v1 + a * dt, a};
+	}
+	double dt = t - tj - tc;
+	double v2 = v1 + a * tc;
+	double p2 = p1 + v1 * tc + a * tc * tc / 2;
+	return {p2 + v2 * dt + a * dt * dt / 2 - jerk * dt * dt * dt / 6, v2 + a * dt - jerk * dt * dt / 2, a - jerk * dt};
+}
+
+ProfileState MotionProfile::sample(double t) const {
+	double length = std::fabs(distance);
+	double decel_start = up.duration + cruise_time;
+	ProfileState state;
+	if (t <= 0) {
+		return {0, 0, 0};
+	}
+	else if (t < up.duration) {
+		state = sampleRamp(up, t);
+	}
+	else if (t < decel_start) {
+		state = {peak_velocity * (t - up.duration / 2), peak_velocity, 0};
+	}
+	else if (t < decel_start + down.duration) {
+		// the slow-down is a speed-up ramp run backwards from the end
+		ProfileState from_end = sampleRamp(down, decel_start + down.duration - t);
+		state = {length - from_end.position, from_end.velocity, -from_end.acceleration};
+	}
+	else {
+		return {distance, 0, 0};
+	}
+	return {sign * state.position, sign * state.velocity, sign * state.acceleration};
+}
+
+double MotionProfile::getDuration() const {
+	return up.duration + cruise_time + down.duration;
+}
+
+double MotionProfile::getDistance() const {
+	return distance;
+}
+
+double MotionProfile::getPeakVelocity() const {
+	return sign * peak_velocity;
+}
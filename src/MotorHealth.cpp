@@ -0,0 +1,145 @@
+#include "MotorHealth.h"
+#include "Telemetry.h"
+#include <cstdio>
+
+MotorHealth::MotorHealth(uint32_t period_ms) : period_ms(period_ms) {
+	for (int s = 0; s < NUM_SUBSYSTEMS; s++) {
+		scale[s] = 1;
+	}
+}
+
+void MotorHealth::addMotor(pros::Motor* motor, Subsystem subsystem, const char* name) {
+	Entry entry = {};
+	entry.motor = motor;
+	entry.subsystem = subsystem;
+	entry.name = name;
+	entry.time_to_derate = -1;
+	motors.push_back(entry);
+}
+
+void MotorHealth::update() {
+	uint32_t now = pros::millis();
+	double new_scale[NUM_SUBSYSTEMS];
+	for (int s = 0; s < NUM_SUBSYSTEMS; s++) {
+		new_scale[s] = 1;
+	}
+	const Entry* worst = nullptr;
+
+	for (Entry& entry : motors) {
+		double temp = entry.motor->get_temperature();
+		if (temp == PROS_ERR_F) {
+			continue; // unplugged
+		}
+		entry.temperature = temp;
+		entry.over_temp = entry.motor->is_over_temp() == 1;
+		entry.over_current = entry.motor->is_over_current() == 1;
+
+		entry.temps[entry.next] = temp;
+		entry.times[entry.next] = now;
+		entry.next = (entry.next + 1) % HISTORY;
+		if (entry.count < HISTORY) {
+			entry.count++;
+		}
+
+		// least-squares slope over the history, the motors only report
+		// temperature in coarse steps so a plain difference is useless
+		entry.slope = 0;
+		if (entry.count >= 5) {
+			double mean_t = 0, mean_y = 0;
+			for (int i = 0; i < entry.count; i++) {
+				mean_t -= (now - entry.times[i]) / 1000.0;
+				mean_y += entry.temps[i];
+			}
+			mean_t /= entry.count;
+			mean_y /= entry.count;
+			double num = 0, den = 0;
+			for (int i = 0; i < entry.count; i++) {
+				double dt = -((now - entry.times[i]) / 1000.0) - mean_t;
+				num += dt * (entry.temps[i] - mean_y);
+				den += dt * dt;
+			}
+			if (den > 0) {
+				entry.slope = num / den;
+			}
+		}
+
+		entry.time_to_derate = -1;
+		if (entry.slope > 0.002) {
+			entry.time_to_derate = (MOTOR_DERATE_TEMP - temp) / entry.slope;
+			if (entry.time_to_derate < 0) {
+				entry.time_to_derate = 0;
+			}
+		}
+
+		int level = 0;
+		double motor_scale = 1;
+		if (entry.over_temp || temp >= MOTOR_DERATE_TEMP) {
+			level = 3;
+			motor_scale = 0.5;
+		}
+		else if (entry.time_to_derate >= 0 && entry.time_to_derate < 30) {
+			level = 2;
+			motor_scale = 0.75;
+		}
+		else if (temp >= MOTOR_WARN_TEMP || (entry.time_to_derate >= 0 && entry.time_to_derate < 90)) {
+			level = 1;
+			motor_scale = 0.9;
+		}
+		if (level > entry.level || entry.over_current) {
+			telemetry_log("health", "%s temp %.0f slope %.3f derate_in %.0f over_temp %d over_current %d",
+			              entry.name, temp, entry.slope, entry.time_to_derate, entry.over_temp, entry.over_current);
+		}
+		entry.level = level;
+
+		if (motor_scale < new_scale[entry.subsystem]) {
+			new_scale[entry.subsystem] = motor_scale;
+		}
+		if (level > 0 && (worst == nullptr || level > worst->level)) {
+			worst = &entry;
+		}
+	}
+
+	for (int s = 0; s < NUM_SUBSYSTEMS; s++) {
+		scale[s] = new_scale[s];
+	}
+
+	char text[48] = "";
+	if (worst != nullptr) {
+		if (worst->level == 3) {
+			snprintf(text, sizeof(text), "HOT %s %.0fC derating", worst->name, worst->temperature);
+		}
+		else if (worst->time_to_derate >= 0) {
+			snprintf(text, sizeof(text), "Warm %s %.0fC derate in %.0fs", worst->name, worst->temperature, worst->time_to_derate);
+		}
+		else {
+			snprintf(text, sizeof(text), "Warm %s %.0fC", worst->name, worst->temperature);
+		}
+	}
+	warning_mutex.take();
+	warning = text;
+	warning_mutex.give();
+}
+
+void MotorHealth::start() {
+	if (task != nullptr) {
+		return;
+	}
+	task = new pros::Task([this] {
+		uint32_t time = pros::millis();
+		while (true) {
+			update();
+			pros::Task::delay_until(&time, period_ms);
+		}
+	}, TASK_PRIORITY_DEFAULT - 1, TASK_STACK_DEPTH_DEFAULT, "motor health");
+}
+
+double MotorHealth::getScale(Subsystem subsystem) const {
+	return scale[subsystem];
+}
+
+std::string MotorHealth::getWarning() const {
+	warning_mutex.take();
+	std::string copy = warning;
+	warning_mutex.give();
+	return copy;
+}
@@ -0,0 +1,35 @@
+#include "Odometry.h"
+
+Odometry::Odometry(double ticks_per_inch) : ticks_per_inch(ticks_per_inch) {}
+
+void Odometry::update(double fl, double fr, double bl, double br) {
+	if (!initialized) {
+		last_fl = fl;
+		last_fr = fr;
+		last_bl = bl;
+		last_br = br;
+		initialized = true;
+		return;
+	}
+
+	double d_fl = fl - last_fl;
+	double d_fr = fr - last_fr;
+	double d_bl = bl - last_bl;
+	double d_br = br - last_br;
+	last_fl = fl;
+	last_fr = fr;
+	last_bl = bl;
+	last_br = br;
+
+	// inverse of the moveForward/moveRight wheel patterns, rotation cancels out
+	last_forward = (d_fl - d_fr + d_bl - d_br) / 4 / ticks_per_inch;
+	last_right = (d_fl + d_fr - d_bl - d_br) / 4 / ticks_per_inch;
+}
+
+double Odometry::getLastForward() const {
+	return last_forward;
+}
+
+double Odometry::getLastRight() const {
+	return last_right;
+}
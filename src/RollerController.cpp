@@ -0,0 +1,86 @@
+#include "RollerController.h"
+
+// proximity below this and the sensor is looking at nothing
+const int ROLLER_MIN_PROXIMITY = 100;
+const double ROLLER_MIN_SATURATION = 0.3;
+
+RollerColor classifyRoller(double hue, double saturation, int proximity) {
+	if (proximity < ROLLER_MIN_PROXIMITY || saturation < ROLLER_MIN_SATURATION) {
+		return ROLLER_UNKNOWN;
+	}
+	if (hue < 30 || hue > 330) {
+		return ROLLER_RED;
+	}
+	if (hue > 180 && hue < 260) {
+		return ROLLER_BLUE;
+	}
+	return ROLLER_UNKNOWN;
+}
+
+RollerColor allianceRollerColor(Alliance alliance) {
+	return alliance == ALLIANCE_RED ? ROLLER_RED : ROLLER_BLUE;
+}
+
+RollerController::RollerController(uint32_t timeout_ms, uint32_t settle_ms, double creep_speed)
+	: timeout_ms(timeout_ms), settle_ms(settle_ms), creep_speed(creep_speed) {}
+
+void RollerController::start(RollerColor new_target, uint32_t now) {
+	target = new_target;
+	state = ROLLER_SPINNING;
+	creeping = false;
+	start_time = now;
+	first_seen = 0;
+	duration = 0;
+}
+
+bool RollerController::update(double hue, double saturation, int proximity, uint32_t now) {
+	if (state == ROLLER_IDLE || state == ROLLER_DONE || state == ROLLER_TIMED_OUT) {
+		return state != ROLLER_IDLE;
+	}
+	if (now - start_time >= timeout_ms) {
+		state = ROLLER_TIMED_OUT;
+		duration = now - start_time;
+		return true;
+	}
+
+	bool on_target = classifyRoller(hue, saturation, proximity) == target;
+	if (state == ROLLER_SPINNING && on_target) {
+		if (first_seen == 0) {
+			first_seen = now - start_time;
+		}
+		state = ROLLER_SETTLING;
+		settle_start = now;
+	}
+	else if (state == ROLLER_SETTLING) {
+		if (!on_target) {
+			// coasted past the color, come back around slowly
+			state = ROLLER_SPINNING;
+			creeping = true;
+		}
+		else if (now - settle_start >= settle_ms) {
+			state = ROLLER_DONE;
+			duration = now - start_time;
+			return true;
+		}
+	}
+	return false;
+}
+
+double RollerController::getSpeed() const {
+	if (state != ROLLER_SPINNING) {
+		return 0;
+	}
+	return creeping ? creep_speed : 1;
+}
+
+RollerState RollerController::getState() const {
+	return state;
+}
+
+uint32_t RollerController::getDuration() const {
+	return duration;
+}
+
+uint32_t RollerController::getFirstSeen() const {
+	return first_seen;
+}
@@ -0,0 +1,110 @@
+#include "Routine.h"
+
+Step seq(std::vector<Step> steps) {
+	return {STEP_SEQUENCE, "", 0, std::move(steps)};
+}
+
+Step par(std::vector<Step> steps) {
+	return {STEP_PARALLEL, "", 0, std::move(steps)};
+}
+
+Step race(std::vector<Step> steps) {
+	return {STEP_RACE, "", 0, std::move(steps)};
+}
+
+Step deadline(std::vector<Step> steps) {
+	return {STEP_DEADLINE, "", 0, std::move(steps)};
+}
+
+Step act(const std::string& action, double arg) {
+	return {STEP_ACTION, action, arg, {}};
+}
+
+Step delayMs(double ms) {
+	return {STEP_WAIT, "", ms, {}};
+}
+
+Step waitUntil(const std::string& condition, double timeout_ms) {
+	return {STEP_WAIT_UNTIL, condition, timeout_ms, {}};
+}
+
+Step unless(const std::string& condition, Step body) {
+	return {STEP_GUARD, condition, 0, {std::move(body)}};
+}
+
+Step unless(const std::string& condition, Step body, Step recovery) {
+	return {STEP_GUARD, condition, 0, {std::move(body), std::move(recovery)}};
+}
+
+CommandPtr compileRoutine(const Step& step, const ActionTable& table, std::vector<std::string>* errors) {
+	std::vector<CommandPtr> children;
+	for (const Step& child : step.children) {
+		children.push_back(compileRoutine(child, table, errors));
+	}
+
+	switch (step.type) {
+		case STEP_SEQUENCE:
+			return CommandPtr(new SequentialGroup(std::move(children)));
+		case STEP_PARALLEL:
+			return CommandPtr(new ParallelGroup(std::move(children)));
+		case STEP_RACE:
+			return CommandPtr(new RaceGroup(std::move(children)));
+		case STEP_DEADLINE:
+			return CommandPtr(new DeadlineGroup(std::move(children)));
+		case STEP_WAIT:
+			return CommandPtr(new WaitCommand(step.arg));
+		case STEP_WAIT_UNTIL: {
+			auto condition = table.conditions.find(step.name);
+			if (condition == table.conditions.end()) {
+				break;
+			}
+			return CommandPtr(new WaitUntilCommand(step.name, condition->second, step.arg));
+		}
+		case STEP_GUARD: {
+			auto condition = table.conditions.find(step.name);
+			if (condition == table.conditions.end() || children.empty()) {
+				break;
+			}
+			CommandPtr recovery = children.size() > 1 ? std::move(children[1]) : nullptr;
+			return CommandPtr(new GuardCommand(step.name, condition->second, std::move(children[0]),
+			                                   std::move(recovery)));
+		}
+		case STEP_ACTION: {
+			auto action = table.actions.find(step.name);
+			if (action == table.actions.end()) {
+				break;
+			}
+			return action->second(step.arg);
+		}
+	}
+
+	if (errors != nullptr) {
+		errors->push_back("unknown step '" + step.name + "'");
+	}
+	return CommandPtr(new FunctionCommand("missing " + step.name, nullptr));
+}
+
+RoutineRunner::RoutineRunner(CommandPtr root) : root(std::move(root)) {}
+
+bool RoutineRunner::tick(uint32_t now) {
+	if (done) {
+		return true;
+	}
+	if (!started) {
+		root->start(now);
+		started = true;
+	}
+	done = root->update(now);
+	return done;
+}
+
+void RoutineRunner::cancel(uint32_t now) {
+	root->cancel(now);
+	done = true;
+}
+
+std::vector<CommandTiming> RoutineRunner::getTimings() const {
+	std::vector<CommandTiming> timings;
+	root->collectTimings(timings);
+	return timings;
+}
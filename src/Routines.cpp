@@ -0,0 +1,89 @@
+#include "Routine.h"
+
+// Actions available to routines (see robotActions() in main.cpp):
+//   forward, reverse, left, right  distance, same units as moveForward()
+//   rotate_cw, rotate_ccw          degrees
+//   flywheel                       rpm, 0 stops it
+//   fire                           one indexer cycle, the piston stays in when there is no disc
+//   roller                         spins to the alliance color, arg is the
+//                                  spin time (ms) if the optical sensor is missing
+//   intake                         velocity, 0 stops it
+//   replay                         plays back the driver trace on the SD card
+//   square_front, square_back,     pushes that face into the wall ahead and resets
+//   square_left, square_right      the heading and the distance to that wall;
+//                                  arg is the timeout (ms), 0 for 2 s
+// Conditions: flywheel_ready, drive_settled, disc_ready,
+//   contact                        bumped or pushing against something, held
+//                                  for 150 ms; race a move against it to stop
+//                                  at a wall, or wrap a move in unless() to
+//                                  back off when it hits something unplanned
+
+// flywheel motor rpm the shot table gives from the start tile, about 112 in
+// from the goal. 200 is the cartridge's free speed and is never reached
+const double SHOT_RPM = 160;
+
+// spins up, shoots and spins down like the old blocking shoot(), but waits
+// for the flywheel rather than a fixed 800 ms that is short of the spin-up
+static Step shot(double rpm) {
+	return seq({
+		act("flywheel", rpm),
+		waitUntil("flywheel_ready", 1500),
+		act("fire"),
+		act("flywheel", 0),
+		delayMs(500),
+	});
+}
+
+const std::vector<Routine> AUTON_ROUTINES = {
+	// start on the tile right of the roller
+	{"Two shots", seq({
+		shot(SHOT_RPM),
+		delayMs(1000),
+		shot(SHOT_RPM),
+	})},
+	// keeps the flywheel spinning between shots and fires as soon as it recovers
+	{"Two shots fast", seq({
+		act("flywheel", SHOT_RPM),
+		waitUntil("flywheel_ready", 1500),
+		act("fire"),
+		waitUntil("flywheel_ready", 1500),
+		act("fire"),
+		act("flywheel", 0),
+	})},
+	// spins the flywheel up while driving over to the roller
+	{"Roller + two shots", seq({
+		par({
+			act("flywheel", SHOT_RPM),
+			seq({
+				act("right", 40),
+				act("forward", 10),
+				act("roller", 300),
+			}),
+		}),
+		waitUntil("flywheel_ready", 1500),
+		act("fire"),
+		waitUntil("flywheel_ready", 1500),
+		act("fire"),
+		act("flywheel", 0),
+	})},
+	// same, but backs into the wall first so the start-pose error does not
+	// carry into the drive over
+	{"Square + roller + two shots", seq({
+		act("square_back"),
+		par({
+			act("flywheel", SHOT_RPM),
+			seq({
+				act("right", 40),
+				act("forward", 10),
+				act("roller", 300),
+			}),
+		}),
+		waitUntil("flywheel_ready", 1500),
+		act("fire"),
+		waitUntil("flywheel_ready", 1500),
+		act("fire"),
+		act("flywheel", 0),
+	})},
+	// record with partner B in driver control, then pick this to run it back
+	{"Replay recording", act("replay")},
+};
@@ -0,0 +1,140 @@
+#include "ShotTable.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// how far a short/long shot moves the table, and how close two shots need to
+// be to count as the same calibration point
+const double OUTCOME_STEP_RPM = 3;
+const double MERGE_DISTANCE = 4;
+
+ShotTable::ShotTable(std::vector<ShotPoint> points) : points(points) {
+	sortAndFit();
+}
+
+double ShotTable::getRpm(double distance) const {
+	if (points.empty()) {
+		return 0;
+	}
+	if (fitted && points.size() >= 3) {
+		// don't extrapolate the curve past the calibrated range
+		double d = std::clamp(distance, points.front().distance, points.back().distance);
+		return a + b * d + c * d * d;
+	}
+	if (distance <= points.front().distance) {
+		return points.front().rpm;
+	}
+	if (distance >= points.back().distance) {
+		return points.back().rpm;
+	}
+	for (size_t i = 1; i < points.size(); i++) {
+		if (distance <= points[i].distance) {
+			const ShotPoint& lo = points[i - 1];
+			const ShotPoint& hi = points[i];
+			double t = (distance - lo.distance) / (hi.distance - lo.distance);
+			return lo.rpm + t * (hi.rpm - lo.rpm);
+		}
+	}
+	return points.back().rpm;
+}
+
+void ShotTable::setFitted(bool use_fit) {
+	fitted = use_fit;
+	sortAndFit();
+}
+
+bool ShotTable::isFitted() const {
+	return fitted;
+}
+
+void ShotTable::recordOutcome(double distance, double rpm, ShotOutcome outcome) {
+	// a short shot says the right speed was a bit higher, a long one lower
+	double good_rpm = rpm;
+	if (outcome == SHOT_SHORT) {
+		good_rpm += OUTCOME_STEP_RPM;
+	}
+	else if (outcome == SHOT_LONG) {
+		good_rpm -= OUTCOME_STEP_RPM;
+	}
+
+	for (ShotPoint& point : points) {
+		if (std::fabs(point.distance - distance) < MERGE_DISTANCE) {
+			point.distance = (point.distance + distance) / 2;
+			point.rpm = (point.rpm + good_rpm) / 2;
+			sortAndFit();
+			return;
+		}
+	}
+	points.push_back({distance, good_rpm});
+	sortAndFit();
+}
+
+bool ShotTable::loadCsv(const char* path) {
+	FILE* file = fopen(path, "r");
+	if (file == nullptr) {
+		return false;
+	}
+	std::vector<ShotPoint> loaded;
+	char line[64];
+	ShotPoint point;
+	while (fgets(line, sizeof(line), file)) {
+		if (sscanf(line, "%lf,%lf", &point.distance, &point.rpm) == 2) {
+			loaded.push_back(point);
+		}
+	}
+	fclose(file);
+	if (loaded.empty()) {
+		return false;
+	}
+	points = loaded;
+	sortAndFit();
+	return true;
+}
+
+bool ShotTable::saveCsv(const char* path) const {
+	FILE* file = fopen(path, "w");
+	if (file == nullptr) {
+		return false;
+	}
+	fprintf(file, "distance,rpm\n");
+	for (const ShotPoint& point : points) {
+		fprintf(file, "%.1f,%.1f\n", point.distance, point.rpm);
+	}
+	fclose(file);
+	return true;
+}
+
+const std::vector<ShotPoint>& ShotTable::getPoints() const {
+	return points;
+}
+
+void ShotTable::sortAndFit() {
+	std::sort(points.begin(), points.end(), [](const ShotPoint& l, const ShotPoint& r) {
+		return l.distance < r.distance;
+	});
+	if (!fitted || points.size() < 3) {
+		return;
+	}
+
+	// normal equations for rpm = a + b d + c d^2, solved with Cramer's rule
+	double s0 = 0, s1 = 0, s2 = 0, s3 = 0, s4 = 0, t0 = 0, t1 = 0, t2 = 0;
+	for (const ShotPoint& p : points) {
+		double d = p.distance;
+		s0 += 1;
+		s1 += d;
+		s2 += d * d;
+		s3 += d * d * d;
+		s4 += d * d * d * d;
+		t0 += p.rpm;
+		t1 += p.rpm * d;
+		t2 += p.rpm * d * d;
+	}
+	double det = s0 * (s2 * s4 - s3 * s3) - s1 * (s1 * s4 - s3 * s2) + s2 * (s1 * s3 - s2 * s2);
+	if (std::fabs(det) < 1e-9) {
+		fitted = false;
+		return;
+	}
+	a = (t0 * (s2 * s4 - s3 * s3) - s1 * (t1 * s4 - s3 * t2) + s2 * (t1 * s3 - s2 * t2)) / det;
+	b = (s0 * (t1 * s4 - t2 * s3) - t0 * (s1 * s4 - s3 * s2) + s2 * (s1 * t2 - t1 * s2)) / det;
+	c = (s0 * (s2 * t2 - s3 * t1) - s1 * (s1 * t2 - s2 * t1) + t0 * (s1 * s3 - s2 * s2)) / det;
+}
@@ -0,0 +1,147 @@
+#include "Startup.h"
+#include "Telemetry.h"
+#include <algorithm>
+
+const uint32_t POLL_MS = 5;
+
+void Startup::add(const std::string& name, std::function<bool()> run, std::vector<std::string> after) {
+	if (started) {
+		telemetry_log("startup", "%s added after start, ignored", name.c_str());
+		return;
+	}
+	Step step;
+	step.name = name;
+	step.run = run;
+	// only earlier steps can be named, so there are no cycles to wait on
+	for (const std::string& other : after) {
+		int index = find(other);
+		if (index < 0) {
+			telemetry_log("startup", "%s comes after unknown step %s", name.c_str(), other.c_str());
+			continue;
+		}
+		step.after.push_back(index);
+	}
+	steps.push_back(step);
+}
+
+void Startup::start() {
+	if (started) {
+		return;
+	}
+	started = true;
+	begin = pros::millis();
+	for (size_t i = 0; i < steps.size(); i++) {
+		tasks.push_back(new pros::Task([this, i] { runStep(i); }, ("startup " + steps[i].name).c_str()));
+	}
+}
+
+void Startup::runStep(size_t index) {
+	Step& step = steps[index];
+	while (true) {
+		bool ready = true;
+		mutex.take();
+		for (size_t other : step.after) {
+			ready = ready && steps[other].done;
+		}
+		mutex.give();
+		if (ready) {
+			break;
+		}
+		pros::delay(POLL_MS);
+	}
+
+	uint32_t start = pros::millis() - begin;
+	mutex.take();
+	step.start = start;
+	mutex.give();
+	bool ok = step.run();
+
+	mutex.take();
+	step.ok = ok;
+	step.end = pros::millis() - begin;
+	step.done = true;
+	// whichever step finishes last writes the report
+	bool last = !reported;
+	for (const Step& other : steps) {
+		last = last && other.done;
+	}
+	reported = reported || last;
+	mutex.give();
+	if (!ok) {
+		telemetry_log("startup", "%s failed", step.name.c_str());
+	}
+	if (last) {
+		report();
+	}
+}
+
+int Startup::find(const std::string& name) const {
+	for (size_t i = 0; i < steps.size(); i++) {
+		if (steps[i].name == name) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+bool Startup::isDone(const std::string& name) const {
+	int index = find(name);
+	if (index < 0) {
+		return false;
+	}
+	mutex.take();
+	bool done = steps[index].done;
+	mutex.give();
+	return done;
+}
+
+bool Startup::isFinished() const {
+	mutex.take();
+	bool finished = started;
+	for (const Step& step : steps) {
+		finished = finished && step.done;
+	}
+	mutex.give();
+	return finished;
+}
+
+bool Startup::waitFor(const std::string& name, uint32_t timeout_ms) const {
+	int index = find(name);
+	if (index < 0) {
+		return false;
+	}
+	uint32_t start = pros::millis();
+	while (true) {
+		mutex.take();
+		bool done = steps[index].done;
+		bool ok = steps[index].ok;
+		mutex.give();
+		if (done) {
+			return ok;
+		}
+		if (pros::millis() - start >= timeout_ms) {
+			return false;
+		}
+		pros::delay(POLL_MS);
+	}
+}
+
+std::vector<StartupTiming> Startup::getTimings() const {
+	std::vector<StartupTiming> timings;
+	mutex.take();
+	for (const Step& step : steps) {
+		timings.push_back({step.name, step.done, step.ok, step.start, step.end});
+	}
+	mutex.give();
+	return timings;
+}
+
+void Startup::report() const {
+	uint32_t total = 0;
+	for (const StartupTiming& timing : getTimings()) {
+		telemetry_log("startup", "%s at %lu took %lu%s", timing.name.c_str(), (unsigned long)timing.start,
+		              (unsigned long)(timing.end - timing.start), timing.ok ? "" : " (failed)");
+		total = std::max(total, timing.end);
+	}
+	telemetry_log("startup", "ready %lu ms after start", (unsigned long)total);
+}
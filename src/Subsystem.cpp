@@ -0,0 +1,10 @@
+#include "Subsystem.h"
+
+const char* subsystemName(Subsystem subsystem) {
+	switch (subsystem) {
+		case SUBSYSTEM_DRIVE: return "drive";
+		case SUBSYSTEM_FLYWHEEL: return "flywheel";
+		case SUBSYSTEM_INTAKE: return "intake";
+		default: return "?";
+	}
+}
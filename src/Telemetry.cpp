@@ -0,0 +1,13 @@
+#include "main.h"
+#include "Telemetry.h"
+#include <cstdarg>
+#include <cstdio>
+
+void telemetry_log(const char* tag, const char* format, ...) {
+	char buffer[192];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+	printf("%s %lu %s\n", tag, (unsigned long)pros::millis(), buffer);
+}
@@ -0,0 +1,67 @@
+#include "Trace.h"
+#include <cstddef>
+#include <cstring>
+
+TraceWriter::~TraceWriter() {
+	close();
+}
+
+bool TraceWriter::open(const char* path, uint16_t tick_ms, uint16_t profile, uint16_t alliance) {
+	close();
+	file = fopen(path, "wb");
+	if (file == nullptr) {
+		return false;
+	}
+	TraceHeader header = {{'G', 'S', 'T', 'R'}, TRACE_VERSION, tick_ms, profile, alliance};
+	frames = 0;
+	if (fwrite(&header, sizeof(header), 1, file) != 1) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool TraceWriter::write(const TraceFrame& frame) {
+	if (file == nullptr || fwrite(&frame, sizeof(frame), 1, file) != 1) {
+		return false;
+	}
+	frames++;
+	return true;
+}
+
+void TraceWriter::close() {
+	if (file != nullptr) {
+		fclose(file);
+		file = nullptr;
+	}
+}
+
+bool TraceWriter::isOpen() const {
+	return file != nullptr;
+}
+
+uint32_t TraceWriter::getFrameCount() const {
+	return frames;
+}
+
+bool loadTrace(const char* path, TraceHeader& header, std::vector<TraceFrame>& frames) {
+	FILE* file = fopen(path, "rb");
+	if (file == nullptr) {
+		return false;
+	}
+	// version 1 headers end before the alliance
+	header.alliance = 0;
+	bool ok = fread(&header, offsetof(TraceHeader, alliance), 1, file) == 1
+		&& memcmp(header.magic, "GSTR", 4) == 0
+		&& (header.version == 1 || header.version == TRACE_VERSION);
+	if (ok && header.version >= 2) {
+		ok = fread(&header.alliance, sizeof(header.alliance), 1, file) == 1;
+	}
+	frames.clear();
+	TraceFrame frame;
+	while (ok && fread(&frame, sizeof(frame), 1, file) == 1) {
+		frames.push_back(frame);
+	}
+	fclose(file);
+	return ok && !frames.empty();
+}
@@ -0,0 +1,103 @@
+#include "TractionMonitor.h"
+#include <algorithm>
+#include <cmath>
+
+const double G_INCHES = 386.1;        // in/s^2
+const double ACCEL_FILTER = 0.3;      // weight of each new reading, both accelerations
+const double BIAS_FILTER = 0.02;
+const double STILL_SPEED = 0.5;       // in/s of encoder speed that counts as sitting still
+
+TractionMonitor::TractionMonitor(double accel_threshold, double slip_deadband, double full_slip,
+                                 double tracking_gain)
+	: accel_threshold(accel_threshold), slip_deadband(slip_deadband), full_slip(full_slip),
+	  tracking_gain(tracking_gain) {}
+
+void TractionMonitor::update(double forward, double right, double accel_forward, double accel_right, double dt) {
+	if (dt <= 0) {
+		return;
+	}
+	if (!initialized) {
+		// no previous speed to difference against yet
+		for (Axis& axis : axes) {
+			axis = Axis();
+		}
+		axes[AXIS_FORWARD].encoder_speed = forward / dt;
+		axes[AXIS_RIGHT].encoder_speed = right / dt;
+		axes[AXIS_FORWARD].speed = forward / dt;
+		axes[AXIS_RIGHT].speed = right / dt;
+		initialized = true;
+	}
+	updateAxis(axes[AXIS_FORWARD], forward, accel_forward, dt);
+	updateAxis(axes[AXIS_RIGHT], right, accel_right, dt);
+}
+
+void TractionMonitor::updateAxis(Axis& axis, double displacement, double accel_g, double dt) {
+	double encoder_speed = displacement / dt;
+	double encoder_accel = (encoder_speed - axis.encoder_speed) / dt;
+	axis.encoder_speed = encoder_speed;
+	axis.encoder_accel += ACCEL_FILTER * (encoder_accel - axis.encoder_accel);
+
+	double imu_accel = accel_g * G_INCHES;
+	if (std::fabs(encoder_speed) < STILL_SPEED && std::fabs(axis.speed) < STILL_SPEED) {
+		axis.bias += BIAS_FILTER * (imu_accel - axis.bias);
+	}
+	axis.imu_accel += ACCEL_FILTER * (imu_accel - axis.bias - axis.imu_accel);
+
+	// wheels spinning up (or down) faster than the chassis follows
+	axis.breaking_loose = std::fabs(axis.encoder_accel - axis.imu_accel) > accel_threshold;
+
+	axis.speed += axis.imu_accel * dt;
+	// trust the encoders again only once they agree with the estimate
+	double slip = encoder_speed - axis.speed;
+	if (!axis.breaking_loose && std::fabs(slip) < slip_deadband) {
+		axis.speed += tracking_gain * slip;
+	}
+	else if (!axis.breaking_loose) {
+		// settled against something: creep back toward the encoders slowly so
+		// a slip that never happened does not stay latched
+		axis.speed += tracking_gain * 0.1 * slip;
+	}
+
+	double grip = traction(axis);
+	axis.displacement = grip * displacement + (1 - grip) * axis.speed * dt;
+}
+
+double TractionMonitor::traction(const Axis& axis) const {
+	double slip = std::fabs(axis.encoder_speed - axis.speed);
+	if (axis.breaking_loose) {
+		slip = std::max(slip, slip_deadband + full_slip / 2);
+	}
+	return std::clamp(1 - (slip - slip_deadband) / full_slip, 0.0, 1.0);
+}
+
+void TractionMonitor::reset() {
+	initialized = false;
+}
+
+double TractionMonitor::getTraction(TractionAxis axis) const {
+	return traction(axes[axis]);
+}
+
+double TractionMonitor::getTraction() const {
+	return std::min(getTraction(AXIS_FORWARD), getTraction(AXIS_RIGHT));
+}
+
+bool TractionMonitor::isSlipping(TractionAxis axis) const {
+	return getTraction(axis) < 1;
+}
+
+double TractionMonitor::getSlip(TractionAxis axis) const {
+	return axes[axis].encoder_speed - axes[axis].speed;
+}
+
+double TractionMonitor::getSpeed(TractionAxis axis) const {
+	return axes[axis].speed;
+}
+
+double TractionMonitor::getForward() const {
+	return axes[AXIS_FORWARD].displacement;
+}
+
+double TractionMonitor::getRight() const {
+	return axes[AXIS_RIGHT].displacement;
+}
@@ -0,0 +1,74 @@
+#include "TurnController.h"
+#include "HeadingHold.h"
+#include <algorithm>
+#include <cmath>
+
+TurnController::TurnController(const TurnGains& gains, double tolerance, uint32_t settle_ms,
+                               uint32_t timeout_extra_ms)
+	: gains(gains), tolerance(tolerance), settle_ms(settle_ms), timeout_extra_ms(timeout_extra_ms) {}
+
+void TurnController::start(double angle, double heading, uint32_t now) {
+	profile = MotionProfile(angle, {gains.max_velocity, gains.max_accel, gains.max_accel, 0});
+	start_time = now;
+	last_time = now;
+	settled_since = now;
+	last_heading = heading;
+	turned = 0;
+	rate = 0;
+	error = angle;
+	settled = false;
+	timed_out = false;
+}
+
+double TurnController::update(double heading, uint32_t now) {
+	// unwrapped so turns past 180 and the IMU's 0/360 seam both work
+	double step = wrapDegrees(heading - last_heading);
+	turned += step;
+	if (now > last_time) {
+		rate = 0.6 * rate + 0.4 * step / ((now - last_time) / 1000.0);
+	}
+	last_heading = heading;
+	last_time = now;
+
+	double t = (now - start_time) / 1000.0;
+	ProfileState state = profile.sample(t);
+	error = profile.getDistance() - turned;
+
+	bool profile_done = t >= profile.getDuration();
+	if (!profile_done || std::fabs(error) > tolerance) {
+		settled_since = now;
+	}
+	settled = profile_done && now - settled_since >= settle_ms;
+	timed_out = t >= profile.getDuration() + timeout_extra_ms / 1000.0;
+	if (isFinished()) {
+		return 0;
+	}
+
+	double output = gains.kV * state.velocity + gains.kA * state.acceleration
+		+ gains.kP * (state.position - turned) + gains.kD * (state.velocity - rate);
+	// static friction, only while there is somewhere to go
+	if (std::fabs(state.velocity) > 0 || std::fabs(error) > tolerance) {
+		output += std::copysign(gains.kS, std::fabs(state.velocity) > 0 ? state.velocity : error);
+	}
+	return std::clamp(output, -127.0, 127.0);
+}
+
+bool TurnController::isSettled() const {
+	return settled;
+}
+
+bool TurnController::isTimedOut() const {
+	return timed_out;
+}
+
+bool TurnController::isFinished() const {
+	return settled || timed_out;
+}
+
+double TurnController::getError() const {
+	return error;
+}
+
+double TurnController::getDuration() const {
+	return profile.getDuration();
+}
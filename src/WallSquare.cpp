@@ -0,0 +1,103 @@
+#include "WallSquare.h"
+#include "HeadingHold.h"
+#include <cmath>
+
+const uint32_t DEFAULT_TIMEOUT_MS = 2000;
+
+WallSquare::WallSquare(double half_length, double push, double min_current, double balance,
+                       double settled_band, uint32_t flush_ms)
+	: half_length(half_length), push(push), min_current(min_current), balance(balance),
+	  settled_band(settled_band), flush_ms(flush_ms) {}
+
+void WallSquare::start(RobotFace new_face, const Pose& estimate, uint32_t now, uint32_t new_timeout_ms) {
+	face = new_face;
+	timeout_ms = new_timeout_ms > 0 ? new_timeout_ms : DEFAULT_TIMEOUT_MS;
+	wall = wallAhead(estimate.heading + face * 90.0);
+	start_time = now;
+	flush_since = now;
+	flush_heading = estimate.heading;
+	touched = false;
+	flush = false;
+	timed_out = false;
+}
+
+bool WallSquare::update(const double current[4], double heading, bool touching, uint32_t now) {
+	touched = touched || touching;
+
+	// the two halves either side of the pushing face: left and right wheels
+	// for the front and back, front and back wheels for the sides
+	double a, b;
+	if (face == FACE_FRONT || face == FACE_BACK) {
+		a = std::fabs(current[0]) + std::fabs(current[2]);
+		b = std::fabs(current[1]) + std::fabs(current[3]);
+	}
+	else {
+		a = std::fabs(current[0]) + std::fabs(current[1]);
+		b = std::fabs(current[2]) + std::fabs(current[3]);
+	}
+	bool pushing = true;
+	for (int i = 0; i < 4; i++) {
+		pushing = pushing && std::fabs(current[i]) >= min_current;
+	}
+	bool balanced = std::fabs(a - b) <= balance * (a + b);
+
+	// still turning square shows as the heading leaving the band; a noisy
+	// IMU makes a differenced rate useless over such a short window
+	if (!touched || !pushing || !balanced || std::fabs(wrapDegrees(heading - flush_heading)) > settled_band) {
+		flush_since = now;
+		flush_heading = heading;
+	}
+	flush = now - flush_since >= flush_ms;
+	timed_out = !flush && now - start_time >= timeout_ms;
+	return flush || timed_out;
+}
+
+double WallSquare::getForward() const {
+	if (flush || timed_out) {
+		return 0;
+	}
+	return face == FACE_FRONT ? push : face == FACE_BACK ? -push : 0;
+}
+
+double WallSquare::getRight() const {
+	if (flush || timed_out) {
+		return 0;
+	}
+	return face == FACE_RIGHT ? push : face == FACE_LEFT ? -push : 0;
+}
+
+bool WallSquare::isFlush() const {
+	return flush;
+}
+
+bool WallSquare::isTimedOut() const {
+	return timed_out;
+}
+
+Wall WallSquare::getWall() const {
+	return wall;
+}
+
+Pose WallSquare::correct(const Pose& estimate) const {
+	Pose pose = estimate;
+	// squared up: the face points straight at the wall
+	pose.heading = wallHeading(wall) - face * 90.0;
+	// keep the estimate's number of whole turns so the heading does not jump by 360
+	pose.heading += 360 * std::round((estimate.heading - pose.heading) / 360);
+	double inside = FIELD_HALF_SIZE - half_length;
+	switch (wall) {
+		case WALL_FAR:
+			pose.y = inside;
+			break;
+		case WALL_RIGHT:
+			pose.x = inside;
+			break;
+		case WALL_NEAR:
+			pose.y = -inside;
+			break;
+		case WALL_LEFT:
+			pose.x = -inside;
+			break;
+	}
+	return pose;
+}
@@ -6,6 +6,31 @@
 
 #include "main.h"
 #include "RobotSpecifics.h"
+#include "HeadingHold.h"
+#include "InputShaping.h"
+#include "CurrentBudget.h"
+#include "MotorHealth.h"
+#include "Routine.h"
+#include "Telemetry.h"
+#include "Odometry.h"
+#include "Trace.h"
+#include "Field.h"
+#include "ShotTable.h"
+#include "AimAssist.h"
+#include "Localization.h"
+#include "RollerController.h"
+#include "IntakeController.h"
+#include "DiscCounter.h"
+#include "AirBudget.h"
+#include "DualFlywheel.h"
+#include "BatteryCompensation.h"
+#include "TurnController.h"
+#include "DriveController.h"
+#include "TractionMonitor.h"
+#include "CollisionDetector.h"
+#include "WallSquare.h"
+#include "Startup.h"
+#include "pros/apix.h"
 #define M_PI 3.1415
 
 #ifdef GREEN
@@ -16,6 +41,10 @@
 	const int8_t BACK_RIGHT_PORT = 5;
 
 	const int8_t GYRO_PORT = 7;
+	const int8_t GPS_PORT = 10;
+	const int8_t ROLLER_OPTICAL_PORT = 11;
+	const int8_t INTAKE_DISTANCE_PORT = 19;
+	const int8_t INDEXER_DISTANCE_PORT = 20;
 
 	const int8_t SHOOTER_PORT1 = 18; //outside motor
 	const int8_t SHOOTER_PORT2 = 17; //inside motor
@@ -34,6 +63,10 @@
 	const int8_t BACK_RIGHT_PORT = 2;
 
 	const int8_t GYRO_PORT = 6;
+	const int8_t GPS_PORT = 10;
+	const int8_t ROLLER_OPTICAL_PORT = 11;
+	const int8_t INTAKE_DISTANCE_PORT = 19;
+	const int8_t INDEXER_DISTANCE_PORT = 20;
 
 	const int8_t SHOOTER_PORT1 = 9; //outside motor
 	const int8_t SHOOTER_PORT2 = 8; //inside motor
@@ -46,7 +79,53 @@
 
 #endif
 
-#define MOTOR_MAX_SPEED 100
+#define AUTON_TICK_MS 10
+#define ROLLER_TICK_MS 5
+#define INTAKE_TICK_MS 10
+#define FLYWHEEL_TICK_MS 10
+#define FLYWHEEL_LOG_PATH "/usd/flywheel.csv"
+
+const double DRIVE_TICKS_PER_INCH = 1000.0 / 13; // encoder degrees per inch, the scale moveForward() uses
+const double TURN_TICKS_PER_DEGREE = 1000.0 / 81;
+
+#define TRACE_PATH "/usd/trace.bin"
+#define IMU_CALIBRATION_TIMEOUT 3000 // ms, calibration normally takes about 2 s
+#define TRACE_TICK_MS 20
+const double REPLAY_KP = 4;            // stick units per inch of pose error
+const double REPLAY_HEADING_KP = 2;    // stick units per degree
+const double REPLAY_MAX_CORRECTION = 40;
+
+// where the robot starts on red, field coordinates (see Field.h): the tile
+// right of the roller. Blue starts on the matching tile, see startPose()
+const Pose START_POSE = {-35, -58, 0};
+const double ROBOT_HALF_LENGTH = 7.5; // inches, center to the bumpers on every side
+const int PRELOADS = 2; // discs loaded by hand before the match
+
+#define SHOT_TABLE_PATH "/usd/shots.csv"
+
+// GPS sensor position relative to the center of the robot, meters; not yet
+// measured, see USE_GPS
+const double GPS_OFFSET_X = 0;
+const double GPS_OFFSET_Y = -0.15;
+const double METERS_TO_INCHES = 39.37;
+
+// two reservoirs and the 10 mm x 50 mm double acting indexer cylinder
+const AirTank INDEXER_AIR = {
+	400,  // tank_ml
+	100,  // start_psi
+	3.9,  // extend_ml
+	3.3,  // retract_ml
+	40,   // min_psi
+	300,  // full_dwell_ms, measured; shorter has not been tested
+	500,  // max_dwell_ms
+};
+
+const double AIM_TOLERANCE = 2; // degrees off the goal bearing that still counts as aimed
+
+// fractions of the flywheel target: below the first the flywheel takes the
+// current first, it hands it back to the drive above the second
+const double FLYWHEEL_PRIORITY_ENTER = 0.9;
+const double FLYWHEEL_PRIORITY_LEAVE = 0.97;
 
 //Component declaration
 pros::Motor front_left_mtr(FRONT_LEFT_PORT);
@@ -56,15 +135,84 @@ pros::Motor back_right_mtr(BACK_RIGHT_PORT);
 
 pros::Motor Shooter1(SHOOTER_PORT1);
 pros::Motor Shooter2(SHOOTER_PORT2);
+// motor rpm both shooter motors are held at, 0 is off
+int flywheel_target = 0;
+#ifdef SYNC_FLYWHEEL
+DualFlywheel flywheel(DEFAULT_FLYWHEEL_GAINS);
+#endif
+// voltage commands are scaled up as the battery runs down
+BatteryCompensation battery;
+// set when the indexer fires, marks the shot in the flywheel log
+bool flywheel_shot = false;
 pros::Motor IntakeR(INTAKE_PORT_R);
 pros::Motor IntakeL(INTAKE_PORT_L);
 pros::Motor Intake3(INTAKE_PORT_THREE);
 
 pros::Imu gyro(GYRO_PORT);
 double gyro_offset = 0;
+pros::Gps gps(GPS_PORT);
+pros::Optical roller_sensor(ROLLER_OPTICAL_PORT);
+pros::Distance intake_distance(INTAKE_DISTANCE_PORT);
+pros::Distance indexer_distance(INDEXER_DISTANCE_PORT);
 
 // pneumatics
 pros::ADIDigitalOut indexer_piston(INDEXER_PORT);
+bool indexer_out = false;
+// remaining air, every piston change goes through setIndexer() so it is counted
+AirBudget indexer_air(INDEXER_AIR);
+
+// shares the brain's current limit, flywheel goes first while shooting
+CurrentBudget current_budget;
+// temperature watch, eases off hot subsystems before the motors derate
+MotorHealth motor_health;
+
+// pose estimate: wheel odometry and the IMU, corrected by GPS fixes,
+// updated by a background task
+Odometry odometry(DRIVE_TICKS_PER_INCH);
+Localization localization;
+// wheel slip from the IMU accelerometer against the encoders, also under pose_mutex
+TractionMonitor traction;
+// bumps and pushing from the IMU and drive motors, also under pose_mutex
+CollisionDetector collision;
+pros::Mutex pose_mutex;
+
+Alliance alliance = ALLIANCE_RED;
+
+// runs the power-on steps in parallel, see initialize()
+Startup startup;
+// the replay trace, read from the SD card at startup so autonomous does not
+// wait on the file; dropped when a new recording starts
+TraceHeader preloaded_header;
+std::vector<TraceFrame> preloaded_trace;
+bool trace_preloaded = false;
+
+// flywheel speed by distance to the goal, starting from the notes at the top
+// and refined on the SD card from marked practice shots
+ShotTable shot_table({{20, 105}, {36, 112}, {60, 130}, {90, 150}, {120, 166}});
+double last_shot_distance = -1;
+double last_shot_rpm = 0;
+
+// intake speed requested by the driver or autonomous, run through jam
+// detection by a background task. The roller code drives the motors directly
+// while this is 0
+double intake_command = 0;
+IntakeController intake;
+// discs in the robot, counted by the intake task; also guarded by intake_mutex
+DiscCounter discs;
+pros::Mutex intake_mutex;
+
+void setIndexer(bool out) {
+	indexer_piston.set_value(out);
+	if (out == indexer_out) {
+		return;
+	}
+	indexer_out = out;
+	indexer_air.recordActuation(out);
+	if (out) {
+		flywheel_shot = true;
+		telemetry_log("air", "%.0f psi, %d shots left", indexer_air.getPressure(), indexer_air.getShotsLeft());
+	}
+}
 
 //helper functions to work with field-centric x-drive
 double getRawRotation() { //get data from the Vex IMU
@@ -80,92 +228,458 @@ void resetRotation() {
 	gyro_offset = getRawRotation();
 }
 
-void moveForward(int dist){
-	int rot = (dist*1000)/13;
+Pose getPose() {
+	pose_mutex.take();
+	Pose pose = localization.getPose();
+	pose_mutex.give();
+	return pose;
+}
 
-	front_left_mtr.move_relative(rot, MOTOR_MAX_SPEED);
-	front_right_mtr.move_relative(-rot, MOTOR_MAX_SPEED);
-	back_left_mtr.move_relative(rot, MOTOR_MAX_SPEED);
-	back_right_mtr.move_relative(-rot, MOTOR_MAX_SPEED);
+void resetPose(const Pose& pose) {
+	pose_mutex.take();
+	localization.reset(pose);
+	pose_mutex.give();
+}
 
-	pros::delay(500);
+// also zeroes the IMU on the pose's heading, so field-centric driving lines
+// up with the field. The odometry task reads the IMU under the lock, so it
+// never mixes the old offset with the new pose
+void resetPoseAndImu(const Pose& pose) {
+	pose_mutex.take();
+	gyro_offset = getRawRotation() - pose.heading;
+	localization.reset(pose);
+	pose_mutex.give();
 }
 
-void moveReverse(int dist2){
-	int rot = (dist2*1000)/13;
+// the same spot for the other alliance: the field turned half way round its center
+Pose otherSide(const Pose& pose) {
+	return {-pose.x, -pose.y, pose.heading + 180};
+}
 
-	front_left_mtr.move_relative(-rot, MOTOR_MAX_SPEED);
-	front_right_mtr.move_relative(rot, MOTOR_MAX_SPEED);
-	back_left_mtr.move_relative(-rot, MOTOR_MAX_SPEED);
-	back_right_mtr.move_relative(rot, MOTOR_MAX_SPEED);
+Pose startPose() {
+	return alliance == ALLIANCE_BLUE ? otherSide(START_POSE) : START_POSE;
+}
 
-	pros::delay(500);
+// field-centric driving pushes away from the driver, and the blue driver
+// stands at the far wall, half a turn round from the field frame
+double driverHeading() {
+	return getRotation() - (alliance == ALLIANCE_BLUE ? 180 : 0);
 }
 
-void moveLeft(int dist){
-	int rot = (dist*1000)/13;
+// IMU acceleration in the robot frame, g; the sensor sits with its x axis
+// forward and y axis to the left. Zero while it calibrates
+void readImuAccel(double& forward, double& right) {
+	pros::c::imu_accel_s_t accel = gyro.get_accel();
+	if (gyro.is_calibrating() || accel.x == PROS_ERR_F || accel.y == PROS_ERR_F) {
+		forward = right = 0;
+		return;
+	}
+	forward = accel.x;
+	right = -accel.y;
+}
 
-	front_left_mtr.move_relative(-rot, MOTOR_MAX_SPEED);
-	front_right_mtr.move_relative(-rot, MOTOR_MAX_SPEED);
-	back_left_mtr.move_relative(rot, MOTOR_MAX_SPEED);
-	back_right_mtr.move_relative(rot, MOTOR_MAX_SPEED);
+double getTraction() {
+	pose_mutex.take();
+	double grip = traction.getTraction();
+	pose_mutex.give();
+	return grip;
+}
 
-	pros::delay(500);
+bool inContact() {
+	pose_mutex.take();
+	bool contact = collision.inContact();
+	pose_mutex.give();
+	return contact;
 }
 
-void moveRight(int dist){
-	int rot = (dist*1000)/13;
+GpsFix readGps() {
+	pros::c::gps_status_s_t status = gps.get_status();
+	double error = gps.get_error();
+	double heading = gps.get_heading();
+	GpsFix fix;
+	fix.valid = status.x != PROS_ERR_F && error != PROS_ERR_F && heading != PROS_ERR_F;
+	fix.x = status.x * METERS_TO_INCHES;
+	fix.y = status.y * METERS_TO_INCHES;
+	fix.heading = heading;
+	fix.error = error * METERS_TO_INCHES;
+	return fix;
+}
 
-	front_left_mtr.move_relative(rot, MOTOR_MAX_SPEED);
-	front_right_mtr.move_relative(rot, MOTOR_MAX_SPEED);
-	back_left_mtr.move_relative(-rot, MOTOR_MAX_SPEED);
-	back_right_mtr.move_relative(-rot, MOTOR_MAX_SPEED);
+double goalDistance() {
+	double goal_x, goal_y;
+	goalPosition(alliance, goal_x, goal_y);
+	Pose pose = getPose();
+	return std::hypot(goal_x - pose.x, goal_y - pose.y);
+}
 
-	pros::delay(500);
+void odometryTask() {
+	uint32_t time = pros::millis();
+	uint32_t last_report = time;
+	while (true) {
+		double accel_forward, accel_right;
+		readImuAccel(accel_forward, accel_right);
+		pros::Motor* drive[] = {&front_left_mtr, &front_right_mtr, &back_left_mtr, &back_right_mtr};
+		double current[4], rpm[4];
+		for (int i = 0; i < 4; i++) {
+			current[i] = drive[i]->get_current_draw();
+			rpm[i] = drive[i]->get_actual_velocity();
+		}
+#ifdef USE_GPS
+		GpsFix fix = readGps();
+#endif
+		pose_mutex.take();
+		double heading = getRotation();
+		odometry.update(front_left_mtr.get_position(), front_right_mtr.get_position(),
+		                back_left_mtr.get_position(), back_right_mtr.get_position());
+		// slipping wheels overstate the distance, the IMU estimate fills in
+		traction.update(odometry.getLastForward(), odometry.getLastRight(), accel_forward, accel_right, 0.01);
+		localization.predict(traction.getForward(), traction.getRight(), heading, traction.getTraction());
+		bool was_in_contact = collision.inContact();
+		ContactType contact = collision.update(accel_forward, accel_right, current, rpm, traction.getTraction(), time);
+		double impact_direction = collision.getImpactDirection();
+#ifdef USE_GPS
+		localization.correct(fix);
+#endif
+		Pose pose = localization.getPose();
+		double sigma = localization.getStdDev();
+		double slip_forward = traction.getSlip(AXIS_FORWARD);
+		double slip_right = traction.getSlip(AXIS_RIGHT);
+		double grip = traction.getTraction();
+		pose_mutex.give();
+
+		if (contact == CONTACT_IMPACT && !was_in_contact) {
+			telemetry_log("contact", "impact from %.0f deg at x %.1f y %.1f", impact_direction, pose.x, pose.y);
+		}
+		else if (contact == CONTACT_PUSHING && !was_in_contact) {
+			telemetry_log("contact", "pushing at x %.1f y %.1f", pose.x, pose.y);
+		}
+		if (time - last_report >= 500) {
+			telemetry_log("pose", "x %.1f y %.1f heading %.1f sigma %.2f gps %lu/%lu", pose.x, pose.y, pose.heading, sigma,
+			              (unsigned long)localization.getAccepted(), (unsigned long)localization.getRejected());
+			if (grip < 1) {
+				telemetry_log("traction", "%.2f, slip %.1f forward %.1f right in/s", grip, slip_forward, slip_right);
+			}
+			last_report = time;
+		}
+		pros::Task::delay_until(&time, 10);
+	}
 }
 
-void rotateClockwise(int angle){
-	int rot = (angle*1000)/81;
+// x-drive mixer; scales all four outputs down together when any of them would
+// saturate so that translation and rotation keep their ratio at full stick
+void setDrive(double v, double h, double r) {
+	double fl = v + h + r;
+	double fr = -v + h + r;
+	double bl = v - h + r;
+	double br = -v - h + r;
+
+	// same stick, same torque on a low battery; full stick stays full stick
+	double scale = battery.getScale();
+	fl *= scale;
+	fr *= scale;
+	bl *= scale;
+	br *= scale;
+
+	double max = std::max(std::max(std::fabs(fl), std::fabs(fr)), std::max(std::fabs(bl), std::fabs(br)));
+	if (max > 127) {
+		fl = fl * 127 / max;
+		fr = fr * 127 / max;
+		bl = bl * 127 / max;
+		br = br * 127 / max;
+	}
 
-	front_left_mtr.move_relative(rot, MOTOR_MAX_SPEED);
-	front_right_mtr.move_relative(rot, MOTOR_MAX_SPEED);
-	back_left_mtr.move_relative(rot, MOTOR_MAX_SPEED);
-	back_right_mtr.move_relative(rot, MOTOR_MAX_SPEED);
+	front_left_mtr.move_voltage(fl * 12000 / 127);
+	front_right_mtr.move_voltage(fr * 12000 / 127);
+	back_left_mtr.move_voltage(bl * 12000 / 127);
+	back_right_mtr.move_voltage(br * 12000 / 127);
+}
 
-	pros::delay(500);
+// profiled straight move in the robot frame, inches; blocks until settled
+void driveBy(double forward, double right) {
+	DriveController move(DRIVE_TICKS_PER_INCH);
+	uint32_t time = pros::millis();
+	move.start(forward, right, front_left_mtr.get_position(), front_right_mtr.get_position(),
+	           back_left_mtr.get_position(), back_right_mtr.get_position(), getRotation(), time);
+	while (!move.isFinished()) {
+		move.update(front_left_mtr.get_position(), front_right_mtr.get_position(), back_left_mtr.get_position(),
+		            back_right_mtr.get_position(), getRotation(), pros::millis());
+		setDrive(move.getForward(), move.getRight(), move.getRotation());
+		pros::Task::delay_until(&time, AUTON_TICK_MS);
+	}
+	setDrive(0, 0, 0);
+	telemetry_log("drive", "%.0f, %.0f in in %lu ms, %.2f off%s", forward, right,
+	              (unsigned long)(pros::millis() - time), move.getError(), move.isTimedOut() ? ", timed out" : "");
+}
+
+void moveForward(int dist){
+	driveBy(dist, 0);
+}
+
+void moveReverse(int dist2){
+	driveBy(-dist2, 0);
+}
+
+void moveLeft(int dist){
+	driveBy(0, -dist);
+}
+
+void moveRight(int dist){
+	driveBy(0, dist);
+}
+
+// profiled turn on the IMU heading, positive clockwise; blocks until settled
+void turnBy(double angle) {
+	TurnController turn;
+	uint32_t time = pros::millis();
+	turn.start(angle, getRotation(), time);
+	while (!turn.isFinished()) {
+		setDrive(0, 0, turn.update(getRotation(), pros::millis()));
+		pros::Task::delay_until(&time, AUTON_TICK_MS);
+	}
+	setDrive(0, 0, 0);
+	telemetry_log("turn", "%.0f deg in %lu ms, %.1f off%s", angle, (unsigned long)(pros::millis() - time),
+	              turn.getError(), turn.isTimedOut() ? ", timed out" : "");
+}
+
+void rotateClockwise(int angle){
+	turnBy(angle);
 }
 
 void rotateCounterClockwise(int angle){
-	int rot = -(angle*1000)/81;
+	turnBy(-angle);
+}
 
-	front_left_mtr.move_relative(rot, MOTOR_MAX_SPEED);
-	front_right_mtr.move_relative(rot, MOTOR_MAX_SPEED);
-	back_left_mtr.move_relative(rot, MOTOR_MAX_SPEED);
-	back_right_mtr.move_relative(rot, MOTOR_MAX_SPEED);
+// runs the flywheel loop under SYNC_FLYWHEEL, samples the battery, and logs
+// spin-up times and steady speed so they can be compared across a match
+void flywheelTask() {
+	uint32_t time = pros::millis();
+	uint32_t last_report = time;
+	int spin_target = 0;
+	uint32_t spin_start = 0;
+	bool spun_up = true;
+#ifdef LOG_FLYWHEEL
+	FILE* log = nullptr;
+	int log_lines = 0;
+#endif
+	while (true) {
+		battery.update(pros::battery::get_voltage());
+		double rpm1 = Shooter1.get_actual_velocity();
+		double rpm2 = -Shooter2.get_actual_velocity(); // mounted the other way round
 
-	pros::delay(500);
+#ifdef SYNC_FLYWHEEL
+		if (flywheel.getTarget() != flywheel_target) {
+			flywheel.setTarget(flywheel_target);
+		}
+		flywheel.setFeedforwardScale(battery.getScale());
+		flywheel.update(rpm1, rpm2, FLYWHEEL_TICK_MS / 1000.0);
+		Shooter1.move_voltage(flywheel.getVoltage1());
+		Shooter2.move_voltage(-flywheel.getVoltage2());
+#endif
+
+#ifdef LOG_FLYWHEEL
+		// every tick while the flywheel is on or still coasting, in the format flywheel_fit reads
+		if (log == nullptr && flywheel_target != 0 && pros::usd::is_installed()) {
+			log = fopen(FLYWHEEL_LOG_PATH, "w");
+			if (log != nullptr) {
+				fprintf(log, "time_ms,rpm1,rpm2,mv1,mv2,battery_mv,shot\n");
+			}
+		}
+		if (log != nullptr && (flywheel_target != 0 || std::fabs(rpm1) + std::fabs(rpm2) > 2)) {
+			fprintf(log, "%lu,%.1f,%.1f,%d,%d,%d,%d\n", (unsigned long)time, rpm1, rpm2, Shooter1.get_voltage(),
+			        -Shooter2.get_voltage(), pros::battery::get_voltage(), flywheel_shot ? 1 : 0);
+			if (++log_lines % 100 == 0) {
+				fflush(log);
+			}
+		}
+#endif
+		flywheel_shot = false;
+
+		int target = flywheel_target;
+		if (target != spin_target) {
+			spin_target = target;
+			spin_start = time;
+			spun_up = target == 0;
+		}
+		double average = (rpm1 + rpm2) / 2;
+		if (!spun_up && std::fabs(rpm1 - target) < target * 0.05 && std::fabs(rpm2 - target) < target * 0.05) {
+			spun_up = true;
+			telemetry_log("flywheel", "spin-up to %d in %lu ms, battery %.2f V", target,
+			              (unsigned long)(time - spin_start), battery.getVoltage() / 1000);
+		}
+		if (target != 0 && time - last_report >= 500) {
+			telemetry_log("flywheel", "target %d average %.1f difference %.1f battery %.2f V", target, average,
+			              rpm1 - rpm2, battery.getVoltage() / 1000);
+			last_report = time;
+		}
+		pros::Task::delay_until(&time, FLYWHEEL_TICK_MS);
+	}
+}
+
+void spinFlywheel(int rpm) {
+	flywheel_target = rpm;
+#ifndef SYNC_FLYWHEEL
+	if (rpm == 0) {
+		// coast down rather than brake
+		Shooter1.move_voltage(0);
+		Shooter2.move_voltage(0);
+	}
+	else {
+		Shooter1.move_velocity(rpm);
+		Shooter2.move_velocity(-rpm);
+	}
+#endif
+}
+
+// the roller is spun by the intake motors; speed is a fraction of what
+// spin_roller() uses, positive pulls discs in
+void setIntakeSpeed(double speed) {
+	IntakeR.move_velocity(-200 * speed);
+	IntakeL.move_velocity(200 * speed);
+	Intake3.move_velocity(-600 * speed);
+}
+
+int readDistance(pros::Distance& sensor) {
+	int32_t mm = sensor.get();
+	return mm == PROS_ERR ? -1 : mm;
+}
+
+void intakeTask() {
+	uint32_t time = pros::millis();
+	uint32_t jams = 0;
+	while (true) {
+		intake_mutex.take();
+		if (intake_command != 0) {
+			double speed[INTAKE_MOTORS] = {IntakeR.get_actual_velocity() / -200, IntakeL.get_actual_velocity() / 200,
+			                               Intake3.get_actual_velocity() / -600};
+			int current[INTAKE_MOTORS] = {IntakeR.get_current_draw(), IntakeL.get_current_draw(),
+			                              Intake3.get_current_draw()};
+			setIntakeSpeed(intake.update(intake_command, speed, current, time));
+		}
+		discs.update(readDistance(intake_distance), readDistance(indexer_distance),
+		             intake_command > 0 ? 1 : intake_command < 0 ? -1 : 0, time);
+		intake_mutex.give();
+
+		if (intake.getJams() != jams) {
+			jams = intake.getJams();
+			telemetry_log("intake", "jam %lu, %s", (unsigned long)jams,
+			              intake.getState() == INTAKE_STALLED_OUT ? "gave up until released" : "reversing");
+		}
+		pros::Task::delay_until(&time, INTAKE_TICK_MS);
+	}
+}
+
+// stopping happens straight away so the roller code can take the motors
+void setIntakeCommand(double command) {
+	intake_mutex.take();
+	if (command == 0 && intake_command != 0) {
+		const double idle[INTAKE_MOTORS] = {};
+		const int no_current[INTAKE_MOTORS] = {};
+		intake.update(0, idle, no_current, pros::millis());
+		setIntakeSpeed(0);
+	}
+	intake_command = command;
+	intake_mutex.give();
+}
+
+bool discReady() {
+	intake_mutex.take();
+	bool ready = discs.canFire();
+	intake_mutex.give();
+	return ready;
+}
+
+int discCount() {
+	intake_mutex.take();
+	int count = discs.getCount();
+	intake_mutex.give();
+	return count;
+}
+
+bool discSensors() {
+	intake_mutex.take();
+	bool sensors = discs.hasSensors();
+	intake_mutex.give();
+	return sensors;
+}
+
+// the sensors only see discs going past, the ones already loaded are told
+void seedDiscs(int count) {
+	intake_mutex.take();
+	discs.setCount(count);
+	intake_mutex.give();
+	telemetry_log("discs", "seeded with %d", count);
+}
+
+// call right before the piston fires, false means there is nothing to shoot
+bool takeDisc() {
+	intake_mutex.take();
+	bool fired = discs.recordShot();
+	intake_mutex.give();
+	if (!fired) {
+		telemetry_log("discs", "dry fire skipped");
+	}
+	return fired;
 }
 
+// does nothing when there is no disc to shoot
 void shoot(int vel){
+	if (!discReady()) {
+		return;
+	}
+	current_budget.setPriority(SUBSYSTEM_FLYWHEEL);
 
-	Shooter1.move_velocity(vel);
-	Shooter2.move_velocity(-(vel));
+	spinFlywheel(vel);
 
 	pros::delay(800);
-	indexer_piston.set_value(true);
-
-	pros::delay(300);
-	indexer_piston.set_value(false);
+	if (takeDisc()) {
+		setIndexer(true);
+		pros::delay(indexer_air.getDwell());
+		setIndexer(false);
+	}
 
 	pros::delay(100);
-	Shooter1.move_velocity(0);
-	Shooter2.move_velocity(0);
+	spinFlywheel(0);
+	current_budget.setPriority(SUBSYSTEM_DRIVE);
 
 	pros::delay(500);
 }
 
+// fires every disc in the robot on one spin-up. Without the distance
+// sensors the count is unknown and it fires twice like the old macro
+void volley(int vel) {
+	int count = discSensors() ? discCount() : 2;
+	if (count == 0 || !discReady()) {
+		return;
+	}
+	current_budget.setPriority(SUBSYSTEM_FLYWHEEL);
+	spinFlywheel(vel);
+	pros::delay(800);
+
+	for (int i = 0; i < count; i++) {
+		// give the next disc time to drop into the indexer
+		uint32_t start = pros::millis();
+		while (!discReady() && pros::millis() - start < 500) {
+			pros::delay(10);
+		}
+		if (!takeDisc()) {
+			break;
+		}
+		setIndexer(true);
+		pros::delay(indexer_air.getDwell());
+		setIndexer(false);
+		if (i + 1 < count) {
+			pros::delay(700); // flywheel recovery
+		}
+	}
+
+	pros::delay(100);
+	spinFlywheel(0);
+	current_budget.setPriority(SUBSYSTEM_DRIVE);
+}
+
 // 300 works for team side
 void spin_roller(int time) {
+	setIntakeCommand(0);
 	IntakeR.move_velocity(-200);
 	IntakeL.move_velocity(200);
 	Intake3.move_velocity(-600);
@@ -175,163 +689,862 @@ void spin_roller(int time) {
 	Intake3.move_velocity(0);
 }
 
-void on_center_button() {
-	static bool pressed = false;
-	pressed = !pressed;
-	if (pressed) {
-		pros::lcd::set_text(2, "I was pressed!");
-	} else {
-		pros::lcd::clear_line(2);
-	}
+bool rollerSensorConnected() {
+	return roller_sensor.get_hue() != PROS_ERR_F;
 }
 
-void initialize() {
-	pros::lcd::initialize();
+// feeds one optical reading to the roller controller and applies its speed
+bool updateRoller(RollerController& roller) {
+	bool finished = roller.update(roller_sensor.get_hue(), roller_sensor.get_saturation(),
+	                              roller_sensor.get_proximity(), pros::millis());
+	setIntakeSpeed(roller.getSpeed());
+	return finished;
+}
 
-	pros::lcd::register_btn1_cb(on_center_button);
-	resetRotation();
-	pros::lcd::set_background_color(50,191,68);
-	pros::lcd::set_text_color(198, 146, 20);
+void logRoller(const RollerController& roller) {
+	telemetry_log("roller", "%s in %lu ms, color first seen at %lu ms",
+	              roller.getState() == ROLLER_DONE ? "done" : "timed out",
+	              (unsigned long)roller.getDuration(), (unsigned long)roller.getFirstSeen());
 }
 
-void disabled() {}
+// spins until the roller shows the alliance color, falls back to a fixed
+// time when the optical sensor is not connected
+void spin_roller_to_color(int fallback_time) {
+	if (!rollerSensorConnected()) {
+		spin_roller(fallback_time);
+		return;
+	}
+	setIntakeCommand(0);
+	RollerController roller;
+	roller.start(allianceRollerColor(alliance), pros::millis());
+	uint32_t time = pros::millis();
+	while (!updateRoller(roller)) {
+		pros::Task::delay_until(&time, ROLLER_TICK_MS);
+	}
+	setIntakeSpeed(0);
+	logRoller(roller);
+}
 
-void competition_initialize() {
-	gyro.reset();
+// driver input profile, cycled from the brain screen before the match starts
+int driver_profile = 0;
+
+// driver control, one tick at a time. opcontrol() feeds it from the
+// controller and the "replay" autonomous action feeds it from a recorded
+// trace, so a replay goes through exactly the same code as the driver
+struct DriverInput {
+	double left_x;
+	double left_y;
+	double right_x;
+	double right_y;
+	uint16_t held;    // TraceButton bits
+	uint16_t pressed; // TraceButton bits newly pressed this tick
+};
+
+struct DriverState {
+	// heading hold latches on the raw stick, inside the profile's own deadband
+	// (or HeadingHold's minimum, for profiles without one)
+	DriverState(int profile)
+		:
+#ifdef HEADING_HOLD
+		  heading_hold(DRIVER_PROFILES[profile].r.deadband),
+#endif
+		  shaper(DRIVER_PROFILES[profile]), last_time(pros::millis()) {}
+
+	bool indexer_piston_state = false;
+	int motorOn = 0;
+	int rpm = 0;
+	bool auto_rpm = false; // rpm follows the shot table
+	int rpm_trim = 0;      // driver nudge on top of the table
+	AimAssist aim{AIM_TOLERANCE};
+	bool fire_pending = false; // shot requested while the aim was still settling
+	bool flywheel_first = false; // flywheel has the current budget's priority
+#ifdef HEADING_HOLD
+	HeadingHold heading_hold;
+#endif
+	InputShaper shaper;
+	uint32_t last_time;
+};
+
+// RIGHT toggles the indexer piston, every other press fires
+void toggleIndexer(DriverState& state) {
+	if (state.indexer_piston_state && !takeDisc()) {
+		state.fire_pending = false;
+		return;
+	}
+	setIndexer(state.indexer_piston_state);
+	if (state.indexer_piston_state) {
+		// remembered so the shot can be marked hit/short/long for calibration
+		last_shot_distance = goalDistance();
+		last_shot_rpm = state.rpm;
+		telemetry_log("shot", "distance %.1f target %d actual %.1f", last_shot_distance, state.rpm,
+		              Shooter1.get_actual_velocity());
+	}
+	state.indexer_piston_state = !state.indexer_piston_state;
+	state.fire_pending = false;
 }
 
-// start on the tile right of the roller
-void autonomous() {
-	/*
-	moveRight(40);
-	pros::delay(1000);
-	moveForward(10);
-	pros::delay(1000);
-	spin_roller(300);
-	pros::delay(1000);
-	*/
-	shoot(200);
-	pros::delay(1000);
-	shoot(200);
+DriverInput readController(pros::Controller& master) {
+	const pros::controller_digital_e_t buttons[] = {DIGITAL_R1, DIGITAL_R2, DIGITAL_L1, DIGITAL_L2,
+		DIGITAL_UP, DIGITAL_DOWN, DIGITAL_LEFT, DIGITAL_RIGHT, DIGITAL_X, DIGITAL_Y, DIGITAL_A, DIGITAL_B};
+
+	DriverInput input = {};
+	input.left_x = master.get_analog(ANALOG_LEFT_X);
+	input.left_y = master.get_analog(ANALOG_LEFT_Y);
+	input.right_x = master.get_analog(ANALOG_RIGHT_X);
+	input.right_y = master.get_analog(ANALOG_RIGHT_Y);
+	for (int i = 0; i < 12; i++) {
+		if (master.get_digital(buttons[i])) {
+			input.held |= 1 << i;
+		}
+		if (master.get_digital_new_press(buttons[i])) {
+			input.pressed |= 1 << i;
+		}
+	}
+	return input;
 }
 
-void opcontrol() {
- 	bool indexer_piston_state = false;
-	pros::Controller master(pros::E_CONTROLLER_MASTER);
+// correction is added after shaping: x/y in field-frame stick units, r to the
+// rotation command. Only replay uses it
+void driverTick(DriverState& state, const DriverInput& input, const Pose& correction = {0, 0, 0}) {
+	uint32_t now = pros::millis();
+	double dt = (now - state.last_time) / 1000.0;
+	state.last_time = now;
+
+	//field centric x-drive, sticks are shaped before the kinematics
+	state.shaper.update(input.left_x, input.left_y, input.right_x, dt, getTraction());
+	// the replay correction is in the field frame, the sticks in the driver's
+	double flip = alliance == ALLIANCE_BLUE ? -1 : 1;
+	double x = state.shaper.getX() + flip * correction.x;
+	double y = state.shaper.getY() + flip * correction.y;
+	double r = state.shaper.getR();
+	double angle = driverHeading() * M_PI / 180; // converting to radians
+
+	double h = x * cos(angle) - y * sin(angle);
+	double v = x * sin(angle) + y * cos(angle);
+
+	// hot drive motors get eased off before they derate themselves
+	double drive_scale = motor_health.getScale(SUBSYSTEM_DRIVE);
+	h *= drive_scale;
+	v *= drive_scale;
+	r *= drive_scale;
+
+	double rot = r;
+	bool aiming = input.held & BTN_B;
+	if (aiming && !gyro.is_calibrating()) {
+		// aim assist owns rotation, the driver keeps translation
+		double goal_x, goal_y;
+		goalPosition(alliance, goal_x, goal_y);
+		Pose pose = getPose();
+		rot = state.aim.update(bearingTo(pose.x, pose.y, goal_x, goal_y), pose.heading, now);
+#ifdef HEADING_HOLD
+		state.heading_hold.reset();
+#endif
+	}
+	else {
+		state.aim.reset();
+#ifdef HEADING_HOLD
+		if (gyro.is_calibrating()) {
+			state.heading_hold.reset();
+		}
+		else {
+			rot = state.heading_hold.update(input.right_x, r, getRotation(), now);
+		}
+#endif
+	}
+	setDrive(v, h, rot + correction.heading);
 
-	int motorOn = 0;
-	int rpm;
-	while (true) {
+	std::string print_angle = std::to_string(angle * 180 / M_PI);
+	pros::lcd::set_text(2, "Angle: " + print_angle);
+
+	pros::lcd::set_text(3, "RPM1: " + std::to_string(18*Shooter2.get_actual_velocity())); //print rpm of shooter motors for testing
+	pros::lcd::set_text(4, "RPM2: " + std::to_string(18*Shooter1.get_actual_velocity()));
+	pros::lcd::set_text(5, "Current1: " + std::to_string(Shooter2.get_current_draw()));
+	pros::lcd::set_text(6, "Current2: " + std::to_string(Shooter1.get_current_draw()));
+	pros::lcd::set_text(7, motor_health.getWarning());
 
-		//field centric x-drive
-		int x = master.get_analog(ANALOG_LEFT_X);
-		int y = master.get_analog(ANALOG_LEFT_Y);
-		int r = master.get_analog(ANALOG_RIGHT_X);
-		double angle = getRotation() * M_PI / 180; // converting to radians
 
-		int h = x * cos(angle) - y * sin(angle);
-		int v = x * sin(angle) + y * cos(angle);
+#ifdef AUTO_FLYWHEEL
+	if(input.held & BTN_R1) { //turn on shooter, speed follows the distance to the goal
+		state.motorOn = 1;
+		state.auto_rpm = true;
+	}
+#else
+	if(input.held & BTN_R1) { //turn on shooter for high speed
+		state.motorOn = 1;
+		state.rpm = 166;
+	}
+#endif
+	else if(input.held & BTN_R2) { //turn off shooter
+		state.motorOn = 0;
+		state.auto_rpm = false;
+	}
+	else if(input.held & BTN_L1) { //turn on shooter for lower speed
+		state.motorOn = 1;
+		state.auto_rpm = false;
+		state.rpm = 110;
+	}
+
+	if (state.auto_rpm) {
+		state.rpm = std::clamp((int)std::lround(shot_table.getRpm(goalDistance())) + state.rpm_trim, 0, 200);
+	}
 
-		front_left_mtr.move(v+h+r);
-		front_right_mtr.move(-v+h+r);
-		back_left_mtr.move(v-h+r);
-		back_right_mtr.move(-v-h+r);
+	//set motor voltages to values to either max or zero voltage
+	if (state.motorOn == 0) {
+		spinFlywheel(0);
+	}
+	else if (state.motorOn == 1) {
+		spinFlywheel(state.rpm);
+	}
 
-		std::string print_angle = std::to_string(angle * 180 / M_PI);
-		pros::lcd::set_text(2, "Angle: " + print_angle);
+	// flywheel gets the current first while it is spinning up or recovering;
+	// the gap between the two thresholds keeps speed noise from flipping it
+	double flywheel_speed = std::fabs(Shooter1.get_actual_velocity());
+	if (state.motorOn != 1) {
+		state.flywheel_first = false;
+	}
+	else if (flywheel_speed < state.rpm * FLYWHEEL_PRIORITY_ENTER) {
+		state.flywheel_first = true;
+	}
+	else if (flywheel_speed > state.rpm * FLYWHEEL_PRIORITY_LEAVE) {
+		state.flywheel_first = false;
+	}
+	current_budget.setPriority(state.flywheel_first ? SUBSYSTEM_FLYWHEEL : SUBSYSTEM_DRIVE);
 
-		pros::lcd::set_text(3, "RPM1: " + std::to_string(18*Shooter2.get_actual_velocity())); //print rpm of shooter motors for testing
-		pros::lcd::set_text(4, "RPM2: " + std::to_string(18*Shooter1.get_actual_velocity()));
-		pros::lcd::set_text(5, "Current1: " + std::to_string(Shooter2.get_current_draw()));
-		pros::lcd::set_text(6, "Current2: " + std::to_string(Shooter1.get_current_draw()));
+	if(input.pressed & BTN_UP){
+		if (state.auto_rpm) {
+			state.rpm_trim += 5;
+		}
+		state.rpm = state.rpm + 5;
+		if(state.rpm > 200){
+			state.rpm = 200;
+		}
+		pros::lcd::set_text(1, "RPM_Get: " + std::to_string(state.rpm));
+		spinFlywheel(state.rpm);
+	}
+	else if(input.pressed & BTN_DOWN){
+		if (state.auto_rpm) {
+			state.rpm_trim -= 5;
+		}
+		state.rpm = state.rpm - 5;
+		if(state.rpm < 0){
+			state.rpm = 0;
+		}
+		pros::lcd::set_text(1, "RPM_Get: " + std::to_string(state.rpm));
+		spinFlywheel(state.rpm);
+	}
 
+	double intake_scale = motor_health.getScale(SUBSYSTEM_INTAKE);
+	if(input.held & BTN_X)
+	{
+		setIntakeCommand(intake_scale);
+	}
+	else if(input.held & BTN_Y)
+	{
+		setIntakeCommand(-intake_scale);
+	}
+	else {
+		setIntakeCommand(0);
+	}
 
-		if(master.get_digital(DIGITAL_R1)) { //turn on shooter for high speed
-			motorOn = 1;
-			rpm = 166;
+	// while aiming, shots wait until the heading has settled on the goal
+	bool can_fire = !aiming || state.aim.isSettled();
+	if (input.pressed & BTN_RIGHT) {
+		if (state.indexer_piston_state && !can_fire) {
+			state.fire_pending = true;
 		}
-		else if(master.get_digital(DIGITAL_R2)) { //turn off shooter
-			motorOn = 0;
+		else {
+			toggleIndexer(state);
 		}
-		else if(master.get_digital(DIGITAL_L1)) { //turn on shooter for lower speed
-			motorOn = 1;
-			rpm = 110;
+	}
+	else if (state.fire_pending && can_fire) {
+		toggleIndexer(state);
+	}
+	if (!aiming || !state.indexer_piston_state) {
+		state.fire_pending = false;
+	}
+	if ((input.pressed & BTN_LEFT) && can_fire) {
+		volley(150);
+	}
+	if (input.pressed & BTN_L2) {
+		spin_roller_to_color(300);
+	}
+}
+
+// replays TRACE_PATH through driverTick(), steering back onto the recorded
+// pose so wheel slip during the replay does not add up
+struct ReplayState {
+	std::vector<TraceFrame> frames;
+	size_t next = 0;
+	DriverInput input = {};
+	Pose target = {0, 0, 0};
+	DriverState driver{0};
+	uint32_t start_time = 0;
+	int flywheel_before = 0; // flywheel target to go back to afterwards
+};
+
+CommandPtr replayCommand() {
+	std::shared_ptr<ReplayState> replay(new ReplayState());
+	return CommandPtr(new FunctionCommand("replay",
+		[=] {
+			TraceHeader header;
+			header.profile = 0;
+			header.alliance = alliance;
+			if (trace_preloaded) {
+				header = preloaded_header;
+				replay->frames = preloaded_trace;
+			}
+			else if (!loadTrace(TRACE_PATH, header, replay->frames)) {
+				telemetry_log("trace", "could not load %s", TRACE_PATH);
+			}
+			// recorded on the other alliance: the same run turned round the field,
+			// the sticks already follow since driving is field-centric for each driver
+			if (header.alliance != alliance) {
+				for (TraceFrame& frame : replay->frames) {
+					Pose mirrored = otherSide({frame.x, frame.y, frame.heading});
+					frame.x = mirrored.x;
+					frame.y = mirrored.y;
+					frame.heading = mirrored.heading;
+				}
+				telemetry_log("trace", "recorded on the other alliance, mirrored");
+			}
+			replay->next = 0;
+			replay->flywheel_before = flywheel_target;
+			// same input profile the trace was recorded with
+			replay->driver = DriverState(header.profile < NUM_DRIVER_PROFILES ? header.profile : 0);
+			replay->start_time = pros::millis();
+			// the robot is placed where the recording started
+			if (!replay->frames.empty()) {
+				const TraceFrame& first = replay->frames[0];
+				resetPose({first.x, first.y, first.heading});
+			}
+		},
+		[=] {
+			uint32_t elapsed = pros::millis() - replay->start_time;
+			replay->input.pressed = 0;
+			while (replay->next < replay->frames.size() && replay->frames[replay->next].time <= elapsed) {
+				const TraceFrame& frame = replay->frames[replay->next];
+				replay->input.left_x = frame.left_x;
+				replay->input.left_y = frame.left_y;
+				replay->input.right_x = frame.right_x;
+				replay->input.right_y = frame.right_y;
+				replay->input.held = frame.held;
+				replay->input.pressed |= frame.pressed;
+				replay->target = {frame.x, frame.y, frame.heading};
+				replay->next++;
+			}
+
+			Pose pose = getPose();
+			Pose correction = {
+				std::clamp((replay->target.x - pose.x) * REPLAY_KP, -REPLAY_MAX_CORRECTION, REPLAY_MAX_CORRECTION),
+				std::clamp((replay->target.y - pose.y) * REPLAY_KP, -REPLAY_MAX_CORRECTION, REPLAY_MAX_CORRECTION),
+				std::clamp(wrapDegrees(replay->target.heading - pose.heading) * REPLAY_HEADING_KP,
+				           -REPLAY_MAX_CORRECTION, REPLAY_MAX_CORRECTION)};
+			driverTick(replay->driver, replay->input, correction);
+		},
+		[=](uint32_t) { return replay->next >= replay->frames.size(); },
+		[=](bool) {
+			// whatever the last frame had running is not left on
+			setDrive(0, 0, 0);
+			setIntakeCommand(0);
+			setIndexer(false);
+			spinFlywheel(replay->flywheel_before);
+		}));
+}
+
+// autonomous actions, non-blocking versions of the helpers above for the
+// command framework. Routines themselves are declared in Routines.cpp
+
+// set while a drive or turn command has the drive
+bool drive_busy = false;
+
+bool driveSettled() {
+	return !drive_busy;
+}
+
+bool flywheelReady() {
+	return flywheel_target > 0
+		&& std::fabs(Shooter1.get_actual_velocity() - flywheel_target) < flywheel_target * 0.05
+		&& std::fabs(-Shooter2.get_actual_velocity() - flywheel_target) < flywheel_target * 0.05;
+}
+
+// same move as driveBy() for the command framework
+CommandPtr driveCommand(const std::string& name, double forward, double right) {
+	std::shared_ptr<DriveController> move(new DriveController(DRIVE_TICKS_PER_INCH));
+	return CommandPtr(new FunctionCommand(name,
+		[=] {
+			drive_busy = true;
+			move->start(forward, right, front_left_mtr.get_position(), front_right_mtr.get_position(),
+			            back_left_mtr.get_position(), back_right_mtr.get_position(), getRotation(), pros::millis());
+		},
+		[=] {
+			move->update(front_left_mtr.get_position(), front_right_mtr.get_position(), back_left_mtr.get_position(),
+			             back_right_mtr.get_position(), getRotation(), pros::millis());
+			setDrive(move->getForward(), move->getRight(), move->getRotation());
+		},
+		[=](uint32_t) { return move->isFinished(); },
+		[=](bool) {
+			setDrive(0, 0, 0);
+			drive_busy = false;
+			telemetry_log("drive", "%.0f, %.0f in, %.2f off%s", forward, right, move->getError(),
+			              move->isTimedOut() ? ", timed out" : "");
+		}));
+}
+
+// pushes a face into the wall ahead of it and, once flush, resets the heading
+// and the distance to that wall in the pose (and the IMU offset, so
+// field-centric driving stays lined up with the field)
+CommandPtr squareCommand(const std::string& name, RobotFace face, double timeout_ms) {
+	std::shared_ptr<WallSquare> square(new WallSquare(ROBOT_HALF_LENGTH));
+	return CommandPtr(new FunctionCommand(name,
+		[=] {
+			drive_busy = true;
+			square->start(face, getPose(), pros::millis(), timeout_ms);
+		},
+		[=] {
+			pros::Motor* drive[] = {&front_left_mtr, &front_right_mtr, &back_left_mtr, &back_right_mtr};
+			double current[4];
+			for (int i = 0; i < 4; i++) {
+				current[i] = drive[i]->get_current_draw();
+			}
+			square->update(current, getRotation(), inContact(), pros::millis());
+			setDrive(square->getForward(), square->getRight(), 0);
+		},
+		[=](uint32_t) { return square->isFlush() || square->isTimedOut(); },
+		[=](bool) {
+			setDrive(0, 0, 0);
+			drive_busy = false;
+			if (!square->isFlush()) {
+				telemetry_log("square", "wall %d not flush, pose kept", square->getWall());
+				return;
+			}
+			Pose before = getPose();
+			Pose after = square->correct(before);
+			resetPoseAndImu(after);
+			telemetry_log("square", "wall %d, moved %.1f in and %.1f deg", square->getWall(),
+			              std::hypot(after.x - before.x, after.y - before.y), after.heading - before.heading);
+		}));
+}
+
+// same turn as turnBy() for the command framework
+CommandPtr turnCommand(const std::string& name, double angle) {
+	std::shared_ptr<TurnController> turn(new TurnController());
+	return CommandPtr(new FunctionCommand(name,
+		[=] {
+			drive_busy = true;
+			turn->start(angle, getRotation(), pros::millis());
+		},
+		[=] { setDrive(0, 0, turn->update(getRotation(), pros::millis())); },
+		[=](uint32_t) { return turn->isFinished(); },
+		[=](bool) {
+			setDrive(0, 0, 0);
+			drive_busy = false;
+			telemetry_log("turn", "%.0f deg, %.1f off%s", angle, turn->getError(),
+			              turn->isTimedOut() ? ", timed out" : "");
+		}));
+}
+
+void setFlywheel(int vel) {
+	spinFlywheel(vel);
+	current_budget.setPriority(vel > 0 ? SUBSYSTEM_FLYWHEEL : SUBSYSTEM_DRIVE);
+}
+
+void setIntake(double vel) {
+	setIntakeCommand(vel / 200);
+}
+
+const ActionTable& robotActions() {
+	static ActionTable table;
+	if (!table.actions.empty()) {
+		return table;
+	}
+	table.actions["forward"] = [](double dist) {
+		return driveCommand("forward", dist, 0);
+	};
+	table.actions["reverse"] = [](double dist) {
+		return driveCommand("reverse", -dist, 0);
+	};
+	table.actions["left"] = [](double dist) {
+		return driveCommand("left", 0, -dist);
+	};
+	table.actions["right"] = [](double dist) {
+		return driveCommand("right", 0, dist);
+	};
+	table.actions["rotate_cw"] = [](double angle) {
+		return turnCommand("rotate cw", angle);
+	};
+	table.actions["rotate_ccw"] = [](double angle) {
+		return turnCommand("rotate ccw", -angle);
+	};
+	table.actions["square_front"] = [](double timeout_ms) {
+		return squareCommand("square front", FACE_FRONT, timeout_ms);
+	};
+	table.actions["square_back"] = [](double timeout_ms) {
+		return squareCommand("square back", FACE_BACK, timeout_ms);
+	};
+	table.actions["square_left"] = [](double timeout_ms) {
+		return squareCommand("square left", FACE_LEFT, timeout_ms);
+	};
+	table.actions["square_right"] = [](double timeout_ms) {
+		return squareCommand("square right", FACE_RIGHT, timeout_ms);
+	};
+	table.actions["flywheel"] = [](double rpm) {
+		return CommandPtr(new FunctionCommand("flywheel " + std::to_string((int)rpm), [=] { setFlywheel(rpm); }));
+	};
+	table.actions["fire"] = [](double) {
+		std::vector<CommandPtr> steps;
+		steps.emplace_back(new FunctionCommand("piston out", [] {
+			if (takeDisc()) {
+				setIndexer(true);
+			}
+		}));
+		steps.emplace_back(new FunctionCommand("dwell", nullptr, nullptr,
+			[](uint32_t elapsed) { return elapsed >= indexer_air.getDwell(); }));
+		steps.emplace_back(new FunctionCommand("piston in", [] { setIndexer(false); }));
+		steps.emplace_back(new WaitCommand(100));
+		return CommandPtr(new SequentialGroup(std::move(steps), "fire"));
+	};
+	table.actions["roller"] = [](double fallback_time) {
+		// stops on the alliance color, or after fallback_time without the sensor
+		std::shared_ptr<RollerController> roller(new RollerController());
+		std::shared_ptr<bool> use_sensor(new bool(false));
+		return CommandPtr(new FunctionCommand("roller",
+			[=] {
+				setIntakeCommand(0);
+				*use_sensor = rollerSensorConnected();
+				if (*use_sensor) {
+					roller->start(allianceRollerColor(alliance), pros::millis());
+				}
+				else {
+					setIntakeSpeed(1);
+				}
+			},
+			nullptr,
+			[=](uint32_t elapsed) { return *use_sensor ? updateRoller(*roller) : elapsed >= fallback_time; },
+			[=](bool) {
+				setIntakeSpeed(0);
+				if (*use_sensor) {
+					logRoller(*roller);
+				}
+			}));
+	};
+	table.actions["intake"] = [](double vel) {
+		return CommandPtr(new FunctionCommand("intake " + std::to_string((int)vel), [=] { setIntake(vel); }));
+	};
+	table.actions["replay"] = [](double) {
+		return replayCommand();
+	};
+	table.conditions["flywheel_ready"] = flywheelReady;
+	table.conditions["drive_settled"] = driveSettled;
+	table.conditions["disc_ready"] = discReady;
+	table.conditions["contact"] = inContact;
+	return table;
+}
+
+// toggles which goal the robot shoots at
+void on_center_button() {
+	alliance = alliance == ALLIANCE_RED ? ALLIANCE_BLUE : ALLIANCE_RED;
+	pros::lcd::set_text(2, alliance == ALLIANCE_RED ? "Alliance: Red" : "Alliance: Blue");
+	// before the IMU is up its startup step picks the new side up itself
+	if (startup.isDone("imu")) {
+		resetPoseAndImu(startPose());
+	}
+}
+
+void on_left_button() {
+	driver_profile = (driver_profile + 1) % NUM_DRIVER_PROFILES;
+	pros::lcd::set_text(0, std::string("Driver: ") + DRIVER_PROFILES[driver_profile].name);
+}
+
+// cycles through the autonomous routines
+int auton_routine = 0;
+
+void on_right_button() {
+	auton_routine = (auton_routine + 1) % AUTON_ROUTINES.size();
+	pros::lcd::set_text(1, std::string("Auton: ") + AUTON_ROUTINES[auton_routine].name);
+}
+
+struct DeviceCheck {
+	const char* name;
+	int8_t port;
+	pros::c::v5_device_e_t type;
+};
+
+// every smart port the code expects something in
+const DeviceCheck DEVICE_CHECKS[] = {
+	{"FL", FRONT_LEFT_PORT, pros::c::E_DEVICE_MOTOR},
+	{"FR", FRONT_RIGHT_PORT, pros::c::E_DEVICE_MOTOR},
+	{"BL", BACK_LEFT_PORT, pros::c::E_DEVICE_MOTOR},
+	{"BR", BACK_RIGHT_PORT, pros::c::E_DEVICE_MOTOR},
+	{"Shoot1", SHOOTER_PORT1, pros::c::E_DEVICE_MOTOR},
+	{"Shoot2", SHOOTER_PORT2, pros::c::E_DEVICE_MOTOR},
+	{"IntakeR", INTAKE_PORT_R, pros::c::E_DEVICE_MOTOR},
+	{"IntakeL", INTAKE_PORT_L, pros::c::E_DEVICE_MOTOR},
+	{"Intake3", INTAKE_PORT_THREE, pros::c::E_DEVICE_MOTOR},
+	{"IMU", GYRO_PORT, pros::c::E_DEVICE_IMU},
+	{"GPS", GPS_PORT, pros::c::E_DEVICE_GPS},
+	{"Optical", ROLLER_OPTICAL_PORT, pros::c::E_DEVICE_OPTICAL},
+	{"IntakeDist", INTAKE_DISTANCE_PORT, pros::c::E_DEVICE_DISTANCE},
+	{"IndexDist", INDEXER_DISTANCE_PORT, pros::c::E_DEVICE_DISTANCE},
+};
+
+// logs every device that is missing or not what the code expects, and lists
+// them on the LCD so a loose cable is caught in the queue rather than the match
+bool checkDevices() {
+	std::string missing;
+	for (const DeviceCheck& check : DEVICE_CHECKS) {
+		pros::c::v5_device_e_t plugged = pros::c::registry_get_plugged_type(std::abs(check.port) - 1);
+		if (plugged != check.type) {
+			telemetry_log("check", "%s on port %d: found device type %d", check.name, std::abs(check.port), (int)plugged);
+			missing += missing.empty() ? check.name : std::string(" ") + check.name;
 		}
+	}
+	pros::lcd::set_text(3, missing.empty() ? "Devices OK" : "Missing: " + missing);
+	return missing.empty();
+}
 
-		//set motor voltages to values to either max or zero voltage
-		if (motorOn == 0) {
-			Shooter1.move_voltage(0);
-			Shooter2.move_voltage(0);
+void initialize() {
+	// initialize() returns straight away and the steps finish in the
+	// background, so competition_initialize() and a quick autonomous are not
+	// held up; autonomous() only waits for the IMU
+	startup.add("imu", [] {
+		// not blocking; an unplugged IMU fails straight away rather than
+		// holding autonomous for the whole timeout
+		if (gyro.reset() == PROS_ERR) {
+			resetPoseAndImu(startPose());
+			return false;
+		}
+		uint32_t start = pros::millis();
+		// is_calibrating() can still read false for a moment after reset()
+		pros::delay(50);
+		while (gyro.is_calibrating() && pros::millis() - start < IMU_CALIBRATION_TIMEOUT) {
+			pros::delay(10);
+		}
+		bool ok = !gyro.is_calibrating() && gyro.get_heading() != PROS_ERR_F;
+		// only now is there a heading to zero on
+		resetPoseAndImu(startPose());
+		return ok;
+	});
+	startup.add("sd card", [] {
+		if (!pros::usd::is_installed()) {
+			return false;
+		}
+		if (shot_table.loadCsv(SHOT_TABLE_PATH)) {
+			telemetry_log("shot", "loaded %d calibration points", (int)shot_table.getPoints().size());
+		}
+		preloaded_header.profile = 0;
+		trace_preloaded = loadTrace(TRACE_PATH, preloaded_header, preloaded_trace);
+		if (trace_preloaded) {
+			telemetry_log("trace", "loaded %lu frames", (unsigned long)preloaded_trace.size());
 		}
-		else if (motorOn == 1) {
- 			Shooter1.move_velocity(rpm);
- 			Shooter2.move_velocity(-rpm);
+		return true;
+	});
+	startup.add("lcd", [] {
+		pros::lcd::initialize();
+		pros::lcd::register_btn1_cb(on_center_button);
+		pros::lcd::register_btn0_cb(on_left_button);
+		pros::lcd::register_btn2_cb(on_right_button);
+		pros::lcd::set_text(0, std::string("Driver: ") + DRIVER_PROFILES[driver_profile].name);
+		pros::lcd::set_text(1, std::string("Auton: ") + AUTON_ROUTINES[auton_routine].name);
+		pros::lcd::set_text(2, alliance == ALLIANCE_RED ? "Alliance: Red" : "Alliance: Blue");
+		pros::lcd::set_background_color(50,191,68);
+		pros::lcd::set_text_color(198, 146, 20);
+		return true;
+	});
+	startup.add("sensors", [] {
+		gps.set_offset(GPS_OFFSET_X, GPS_OFFSET_Y);
+		roller_sensor.set_led_pwm(100); // steady lighting so the hue thresholds hold
+		roller_sensor.disable_gesture();
+		return true;
+	});
+	startup.add("self check", checkDevices, {"lcd"});
+	startup.start();
+
+	current_budget.addMotor(&front_left_mtr, SUBSYSTEM_DRIVE);
+	current_budget.addMotor(&front_right_mtr, SUBSYSTEM_DRIVE);
+	current_budget.addMotor(&back_left_mtr, SUBSYSTEM_DRIVE);
+	current_budget.addMotor(&back_right_mtr, SUBSYSTEM_DRIVE);
+	current_budget.addMotor(&Shooter1, SUBSYSTEM_FLYWHEEL);
+	current_budget.addMotor(&Shooter2, SUBSYSTEM_FLYWHEEL);
+	current_budget.addMotor(&IntakeR, SUBSYSTEM_INTAKE);
+	current_budget.addMotor(&IntakeL, SUBSYSTEM_INTAKE);
+	current_budget.addMotor(&Intake3, SUBSYSTEM_INTAKE);
+	current_budget.start();
+
+	motor_health.addMotor(&front_left_mtr, SUBSYSTEM_DRIVE, "FL");
+	motor_health.addMotor(&front_right_mtr, SUBSYSTEM_DRIVE, "FR");
+	motor_health.addMotor(&back_left_mtr, SUBSYSTEM_DRIVE, "BL");
+	motor_health.addMotor(&back_right_mtr, SUBSYSTEM_DRIVE, "BR");
+	motor_health.addMotor(&Shooter1, SUBSYSTEM_FLYWHEEL, "Shoot1");
+	motor_health.addMotor(&Shooter2, SUBSYSTEM_FLYWHEEL, "Shoot2");
+	motor_health.addMotor(&IntakeR, SUBSYSTEM_INTAKE, "IntakeR");
+	motor_health.addMotor(&IntakeL, SUBSYSTEM_INTAKE, "IntakeL");
+	motor_health.addMotor(&Intake3, SUBSYSTEM_INTAKE, "Intake3");
+	motor_health.start();
+
+	// whatever odometry tracks before the IMU step finishes is replaced by its reset
+	pros::Task odometry_task(odometryTask, "odometry");
+	pros::Task intake_task(intakeTask, "intake");
+	pros::Task flywheel_task(flywheelTask, "flywheel");
+}
+
+void disabled() {}
+
+// the IMU already calibrates during startup; resetting it again here left it
+// unusable for the first two seconds of an autonomous that started right after.
+// The tank is pumped up in the queue, so the air estimate starts over
+void competition_initialize() {
+	indexer_air.reset();
+}
+
+// set once autonomous has run, so driver control keeps its disc count
+bool auton_ran = false;
+
+void autonomous() {
+	auton_ran = true;
+	seedDiscs(PRELOADS);
+
+	// a match started straight after power-on needs the IMU, the rest of the
+	// startup can keep going in the background
+	if (!startup.isDone("imu")) {
+		uint32_t wait = pros::millis();
+		bool ok = startup.waitFor("imu", IMU_CALIBRATION_TIMEOUT);
+		telemetry_log("auton", "waited %lu ms for the IMU%s", (unsigned long)(pros::millis() - wait),
+		              ok ? "" : ", not calibrated");
+	}
+	// the robot is set down on its alliance's start tile, whatever happened before
+	resetPoseAndImu(startPose());
+
+	const Routine& routine = AUTON_ROUTINES[auton_routine];
+	std::vector<std::string> errors;
+	RoutineRunner runner(compileRoutine(routine.root, robotActions(), &errors));
+	for (const std::string& error : errors) {
+		telemetry_log("auton", "%s", error.c_str());
+	}
+
+	uint32_t start = pros::millis();
+	uint32_t time = start;
+	while (!runner.tick(pros::millis())) {
+		pros::Task::delay_until(&time, AUTON_TICK_MS);
+	}
+
+	// where the 15 s went, one line per command in tree order
+	telemetry_log("auton", "%s finished in %lu ms", routine.name, (unsigned long)(pros::millis() - start));
+	for (const CommandTiming& timing : runner.getTimings()) {
+		telemetry_log("auton", "%*s%s at %lu took %lu%s", timing.depth * 2, "", timing.name.c_str(),
+		              (unsigned long)(timing.start - start), (unsigned long)(timing.end - timing.start),
+		              !timing.ran ? " (skipped)" : timing.interrupted ? " (cancelled)" : "");
+	}
+}
+
+// partner controller marks the last shot during calibration practice:
+// A hit, DOWN short, UP long. The table is saved back to the SD card
+void markShot(pros::Controller& partner) {
+	if (last_shot_distance < 0) {
+		return;
+	}
+	ShotOutcome outcome;
+	if (partner.get_digital_new_press(DIGITAL_A)) {
+		outcome = SHOT_HIT;
+	}
+	else if (partner.get_digital_new_press(DIGITAL_DOWN)) {
+		outcome = SHOT_SHORT;
+	}
+	else if (partner.get_digital_new_press(DIGITAL_UP)) {
+		outcome = SHOT_LONG;
+	}
+	else {
+		return;
+	}
+	shot_table.recordOutcome(last_shot_distance, last_shot_rpm, outcome);
+	telemetry_log("shot", "marked %s at %.1f rpm %.0f", outcome == SHOT_HIT ? "hit" : outcome == SHOT_SHORT ? "short" : "long",
+	              last_shot_distance, last_shot_rpm);
+	last_shot_distance = -1;
+	if (pros::usd::is_installed()) {
+		shot_table.saveCsv(SHOT_TABLE_PATH);
+	}
+}
+
+void opcontrol() {
+	pros::Controller master(pros::E_CONTROLLER_MASTER);
+	pros::Controller partner(pros::E_CONTROLLER_PARTNER);
+	DriverState state(driver_profile);
+	// straight into driver control (practice, skills) the robot holds the
+	// preloads on its start tile; after autonomous the count and the pose
+	// carry on from there
+	if (!auton_ran) {
+		seedDiscs(PRELOADS);
+		resetPoseAndImu(startPose());
+	}
+
+	// partner B starts and stops recording a trace to the SD card for autonomous replay
+	TraceWriter recorder;
+	uint32_t record_start = 0;
+	uint32_t last_record = 0;
+	uint16_t record_pressed = 0;
+
+	// disc count and air on the controller screen, which only takes an update every 50 ms
+	int shown_discs = -1;
+	int shown_psi = -1;
+	uint32_t last_screen = 0;
+
+	while (true) {
+		DriverInput input = readController(master);
+
+		// partner X after re-pumping the tank without a reboot
+		if (partner.get_digital_new_press(DIGITAL_X)) {
+			indexer_air.reset();
+			telemetry_log("air", "reset to %.0f psi", indexer_air.getPressure());
+			partner.rumble(".");
 		}
 
-		if(master.get_digital_new_press(DIGITAL_UP)){
-			rpm = rpm + 5;
-			if(rpm > 200){
-				rpm = 200;
+		if (partner.get_digital_new_press(DIGITAL_B)) {
+			if (recorder.isOpen()) {
+				recorder.close();
+				telemetry_log("trace", "stopped, %lu frames", (unsigned long)recorder.getFrameCount());
+				partner.rumble("..");
+			}
+			else if (pros::usd::is_installed() && recorder.open(TRACE_PATH, TRACE_TICK_MS, driver_profile, alliance)) {
+				trace_preloaded = false;
+				record_start = pros::millis();
+				last_record = record_start - TRACE_TICK_MS;
+				record_pressed = 0;
+				telemetry_log("trace", "recording to %s", TRACE_PATH);
+				partner.rumble("-");
 			}
-			pros::lcd::set_text(1, "RPM_Get: " + std::to_string(rpm));
-	 		Shooter1.move_velocity(rpm);
-	 		Shooter2.move_velocity(-(rpm));
-		}
-		else if(master.get_digital_new_press(DIGITAL_DOWN)){
-			rpm = rpm - 5;
-			if(rpm < 0){
-				rpm = 0;
+			else {
+				telemetry_log("trace", "no SD card");
+			}
+		}
+
+		driverTick(state, input);
+		markShot(partner);
+
+		int count = discCount();
+		int psi = (int)indexer_air.getPressure();
+		if ((count != shown_discs || psi != shown_psi) && pros::millis() - last_screen >= 60) {
+			std::string text = "Discs " + std::to_string(count) + " Air " + std::to_string(psi) +
+			                   (indexer_air.isLow() ? "!" : "");
+			text.resize(15, ' '); // clears what was there before
+			master.set_text(0, 0, text);
+			shown_discs = count;
+			shown_psi = psi;
+			last_screen = pros::millis();
+		}
+
+		if (recorder.isOpen()) {
+			// presses between frames are kept so none are lost at the coarser tick
+			record_pressed |= input.pressed;
+			uint32_t now = pros::millis();
+			if (now - last_record >= TRACE_TICK_MS) {
+				Pose pose = getPose();
+				TraceFrame frame = {now - record_start, (int8_t)input.left_x, (int8_t)input.left_y,
+				                    (int8_t)input.right_x, (int8_t)input.right_y, input.held, record_pressed,
+				                    (float)pose.x, (float)pose.y, (float)pose.heading};
+				recorder.write(frame);
+				record_pressed = 0;
+				last_record = now;
 			}
-			pros::lcd::set_text(1, "RPM_Get: " + std::to_string(rpm));
-	 		Shooter1.move_velocity(rpm);
-	 		Shooter2.move_velocity(-(rpm));
-		}
-
-		if(master.get_digital_new_press(DIGITAL_A)) {
-			gyro.reset(); //manual reset of gyro for testing
-		}
-
-		if(master.get_digital(DIGITAL_X))
-		{
-			IntakeR.move_velocity(-200);
-			IntakeL.move_velocity(200);
-			Intake3.move_velocity(-600);
-		}
-		else if(master.get_digital(DIGITAL_Y))
-		{
-			IntakeR.move_velocity(200);
-			IntakeL.move_velocity(-200);
-			Intake3.move_velocity(600);
-		}
-    	else {
-      		IntakeR.move_velocity(0);
-			IntakeL.move_velocity(0);
-			Intake3.move_velocity(0);
-    	}
-
-    if (master.get_digital_new_press(DIGITAL_RIGHT)) {
-      indexer_piston.set_value(indexer_piston_state);
-      indexer_piston_state = !indexer_piston_state;
-    }
-	if (master.get_digital_new_press(DIGITAL_LEFT)) {
-      shoot(150);
-	  pros::delay(1500);
-	  shoot(150);
-    }
-	if (master.get_digital_new_press(DIGITAL_L2)) {
-      spin_roller(300);
-    }
-
-		//X-drive
-		/*
-		intx = master.get_analog(ANALOG_LEFT_X);
-		int y = master.get_analog(ANALOG_LEFT_Y);
-		int r = master.get_analog(ANALOG_RIGHT_X);
-		front_left_mtr.move(y+x+r);
-		front_right_mtr.move(-y+x+r);
-		back_left_mtr.move(y-x+r);
-		back_right_mtr.move(-y-x+r);
-		*/
+		}
 
 		pros::delay(2);
 	}